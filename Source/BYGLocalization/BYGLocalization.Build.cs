@@ -19,8 +19,20 @@ public class BYGLocalization : ModuleRules
 			new string[]
 			{
 				"CoreUObject",
-				"Engine"
+				"Engine",
+				"Json",
 			}
 			);
+
+		// Used to hot reload localization files, it's a developer module so it can't ship
+		if ( Target.Configuration != UnrealTargetConfiguration.Shipping )
+		{
+			PrivateDependencyModuleNames.Add( "DirectoryWatcher" );
+			PrivateDefinitions.Add( "BYG_WITH_HOT_RELOAD=1" );
+		}
+		else
+		{
+			PrivateDefinitions.Add( "BYG_WITH_HOT_RELOAD=0" );
+		}
 	}
 }
@@ -0,0 +1,242 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StringView.h"
+
+// Single-pass, quote-aware CSV reader that works in-place on a buffer we own.
+// Cells are handed out as views into the buffer. Escaped quotes ("") are collapsed in place, so the
+// views stay valid for as long as the buffer is alive and unmodified.
+// Follows RFC 4180: quoted cells may contain commas, newlines and "" for a literal quote.
+// Works on TCHAR text or straight on UTF-8 bytes as ANSICHAR. Everything it looks for is ASCII, and every byte of
+// a multi-byte UTF-8 character is above 127, so cells split the same way either way
+template <typename CharType>
+class TBYGCSVParser
+{
+public:
+	typedef TStringView<CharType> FCellView;
+	typedef TArray<FCellView, TInlineAllocator<8>> FRow;
+
+	// Note that InBuffer is modified as it is parsed
+	explicit TBYGCSVParser( FString& InBuffer )
+		: TBYGCSVParser( InBuffer.GetCharArray().GetData(), InBuffer.Len() )
+	{
+	}
+	TBYGCSVParser( CharType* InBuffer, int32 InLen )
+	{
+		if ( InLen > 0 )
+		{
+			ReadAt = InBuffer;
+			End = InBuffer + InLen;
+		}
+	}
+
+	// Returns false when there are no more rows
+	bool ParseRow( FRow& OutCells )
+	{
+		OutCells.Reset();
+
+		if ( ReadAt >= End )
+			return false;
+
+		RowLineNumber = CurrentLine;
+		bUnterminatedQuote = false;
+
+		FCellView Cell;
+		ECellEnd Result;
+		do
+		{
+			Result = ParseCell( Cell );
+			OutCells.Add( Cell );
+		} while ( Result == ECellEnd::Delimiter );
+
+		return true;
+	}
+
+	// Column-projected version of ParseRow. Only the cell at Column is unescaped and returned, all other
+	// cells are stepped over without being written to. OutCell is empty if the row has too few cells.
+	// Returns false when there are no more rows
+	bool ScanRow( int32 Column, FCellView& OutCell, int32& OutNumCells )
+	{
+		OutCell = FCellView();
+		OutNumCells = 0;
+
+		if ( ReadAt >= End )
+			return false;
+
+		RowLineNumber = CurrentLine;
+		bUnterminatedQuote = false;
+
+		ECellEnd Result;
+		do
+		{
+			if ( OutNumCells == Column )
+			{
+				Result = ParseCell( OutCell );
+			}
+			else
+			{
+				Result = SkipCell();
+			}
+			++OutNumCells;
+		} while ( Result == ECellEnd::Delimiter );
+
+		return true;
+	}
+
+	// 1-based line number that the last row returned by ParseRow started on
+	int32 GetLineNumber() const { return RowLineNumber; }
+
+	// True if the last row returned by ParseRow hit the end of the file inside a quoted cell
+	bool HasUnterminatedQuote() const { return bUnterminatedQuote; }
+
+	// Convert a cell to an FString with a single allocation
+	static FString ToString( const FStringView& Cell )
+	{
+		return Cell.Len() > 0 ? FString( Cell.Len(), Cell.GetData() ) : FString();
+	}
+	// UTF-8 cells are converted on the stack first, unless they are long
+	static FString ToString( const TStringView<ANSICHAR>& Cell )
+	{
+		if ( Cell.Len() == 0 )
+			return FString();
+
+		const FUTF8ToTCHAR Converted( Cell.GetData(), Cell.Len() );
+		return FString( Converted.Length(), Converted.Get() );
+	}
+
+protected:
+	enum class ECellEnd : uint8
+	{
+		Delimiter,
+		EndOfRow,
+		EndOfFile
+	};
+
+	ECellEnd ParseCell( FCellView& OutCell )
+	{
+		// We only ever write at or behind where we read, so collapsing "" into " can be done in-place
+		CharType* CellStart = ReadAt;
+		CharType* WriteAt = ReadAt;
+
+		// Whitespace before an opening quote means the cell is not quoted
+		if ( ReadAt < End && *ReadAt == '"' )
+		{
+			++ReadAt;
+			CellStart = WriteAt = ReadAt;
+
+			bool bClosed = false;
+			while ( ReadAt < End )
+			{
+				const CharType Ch = *ReadAt;
+				if ( Ch == '"' )
+				{
+					if ( ReadAt + 1 < End && ReadAt[ 1 ] == '"' )
+					{
+						*WriteAt++ = '"';
+						ReadAt += 2;
+						continue;
+					}
+					++ReadAt;
+					bClosed = true;
+					break;
+				}
+				if ( Ch == '\n' || ( Ch == '\r' && ( ReadAt + 1 >= End || ReadAt[ 1 ] != '\n' ) ) )
+				{
+					++CurrentLine;
+				}
+				*WriteAt++ = *ReadAt++;
+			}
+			bUnterminatedQuote |= !bClosed;
+		}
+
+		// Unquoted cells, or anything trailing after a closing quote, runs until the next delimiter
+		while ( ReadAt < End )
+		{
+			const CharType Ch = *ReadAt;
+			if ( Ch == ',' )
+			{
+				++ReadAt;
+				OutCell = FCellView( CellStart, UE_PTRDIFF_TO_INT32( WriteAt - CellStart ) );
+				return ECellEnd::Delimiter;
+			}
+			if ( Ch == '\r' || Ch == '\n' )
+			{
+				// Treat \r\n, \n and \r all as a single line break
+				++ReadAt;
+				if ( Ch == '\r' && ReadAt < End && *ReadAt == '\n' )
+				{
+					++ReadAt;
+				}
+				++CurrentLine;
+				OutCell = FCellView( CellStart, UE_PTRDIFF_TO_INT32( WriteAt - CellStart ) );
+				return ECellEnd::EndOfRow;
+			}
+			*WriteAt++ = *ReadAt++;
+		}
+
+		OutCell = FCellView( CellStart, UE_PTRDIFF_TO_INT32( WriteAt - CellStart ) );
+		return ECellEnd::EndOfFile;
+	}
+
+	ECellEnd SkipCell()
+	{
+		// Same rules as ParseCell, but we only care about where the cell ends
+		if ( ReadAt < End && *ReadAt == '"' )
+		{
+			++ReadAt;
+
+			bool bClosed = false;
+			while ( ReadAt < End )
+			{
+				const CharType Ch = *ReadAt++;
+				if ( Ch == '"' )
+				{
+					if ( ReadAt < End && *ReadAt == '"' )
+					{
+						++ReadAt;
+						continue;
+					}
+					bClosed = true;
+					break;
+				}
+				if ( Ch == '\n' || ( Ch == '\r' && ( ReadAt >= End || *ReadAt != '\n' ) ) )
+				{
+					++CurrentLine;
+				}
+			}
+			bUnterminatedQuote |= !bClosed;
+		}
+
+		while ( ReadAt < End )
+		{
+			const CharType Ch = *ReadAt++;
+			if ( Ch == ',' )
+			{
+				return ECellEnd::Delimiter;
+			}
+			if ( Ch == '\r' || Ch == '\n' )
+			{
+				if ( Ch == '\r' && ReadAt < End && *ReadAt == '\n' )
+				{
+					++ReadAt;
+				}
+				++CurrentLine;
+				return ECellEnd::EndOfRow;
+			}
+		}
+
+		return ECellEnd::EndOfFile;
+	}
+
+	CharType* ReadAt = nullptr;
+	CharType* End = nullptr;
+	int32 CurrentLine = 1;
+	int32 RowLineNumber = 0;
+	bool bUnterminatedQuote = false;
+};
+
+typedef TBYGCSVParser<TCHAR> FBYGCSVParser;
+// Parses UTF-8 files without converting them first
+typedef TBYGCSVParser<ANSICHAR> FBYGUTF8CSVParser;
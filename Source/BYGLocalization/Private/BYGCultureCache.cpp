@@ -0,0 +1,77 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#include "BYGCultureCache.h"
+#include "BYGLocalizationCoreMinimal.h"
+
+#include "Internationalization/Internationalization.h"
+#include "Misc/ScopeLock.h"
+
+FBYGCultureCache& FBYGCultureCache::Get()
+{
+	static FBYGCultureCache Instance;
+	return Instance;
+}
+
+const TMap<FString, FString>& FBYGCultureCache::GetLocaleCodeOverrides()
+{
+	// Both Chinese scripts share one file for now
+	static const TMap<FString, FString> Overrides = {
+		{ TEXT( "zh-CN" ), TEXT( "cn_HANS" ) },
+		{ TEXT( "zh-TW" ), TEXT( "cn_HANS" ) },
+	};
+	return Overrides;
+}
+
+uint32 FBYGCultureCache::FLocaleCodeKeyFuncs::GetKeyHash( FStringView Key )
+{
+	uint32 Hash = 0;
+	for ( int32 i = 0; i < Key.Len(); ++i )
+	{
+		Hash = HashCombine( Hash, FChar::ToLower( Key[ i ] ) );
+	}
+	return Hash;
+}
+
+FBYGCultureCache::FEntry FBYGCultureCache::Find( FStringView LocaleCode )
+{
+	FScopeLock Lock( &CS );
+
+	const uint32 Hash = FLocaleCodeKeyFuncs::GetKeyHash( LocaleCode );
+	if ( const FEntry* Found = Entries.FindByHash( Hash, LocaleCode ) )
+		return *Found;
+
+	BYG_SCOPE_CYCLE_COUNTER( ResolveCulture );
+	BYG_LLM_SCOPE();
+
+	const FString LocaleCodeString( LocaleCode.Len(), LocaleCode.GetData() );
+	FEntry& Entry = Entries.AddByHash( Hash, LocaleCodeString );
+	Entry.Culture = FInternationalization::Get().GetCulture( LocaleCodeString );
+	if ( Entry.Culture.IsValid() )
+	{
+		Entry.NativeName = FText::FromString( Entry.Culture->GetNativeLanguage() );
+	}
+	else
+	{
+		// Couldn't find localized name, just show raw filename
+		Entry.NativeName = FText::FromString( LocaleCodeString );
+	}
+	return Entry;
+}
+
+FString FBYGCultureCache::GetLocaleCodeForCulture( const FCultureRef& Culture )
+{
+	FScopeLock Lock( &CS );
+
+	const FString& CultureName = Culture->GetName();
+	if ( const FString* Found = CultureLocaleCodes.Find( CultureName ) )
+		return *Found;
+
+	const FString* Override = GetLocaleCodeOverrides().Find( CultureName );
+	return CultureLocaleCodes.Add( CultureName, Override ? *Override : Culture->GetTwoLetterISOLanguageName() );
+}
+
+int32 FBYGCultureCache::Num() const
+{
+	FScopeLock Lock( &CS );
+	return Entries.Num();
+}
@@ -0,0 +1,53 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StringView.h"
+#include "HAL/CriticalSection.h"
+#include "Internationalization/Culture.h"
+
+// Remembers what each locale code resolves to, so the culture lookups and native names that go through ICU
+// only happen the first time a code is seen in the process.
+// Cultures and locale codes don't depend on settings, so nothing here is ever invalidated. Safe to use from any thread
+class BYGLOCALIZATION_API FBYGCultureCache
+{
+public:
+	struct FEntry
+	{
+		// Null if no culture matches the locale code
+		FCulturePtr Culture;
+		// The culture's native language name, or the locale code itself if there is no culture
+		FText NativeName;
+	};
+
+	static FBYGCultureCache& Get();
+
+	// e.g. "fr" or "cn_HANS". Case-insensitive, and doesn't allocate once the code is cached
+	FEntry Find( FStringView LocaleCode );
+
+	// The locale code a file for this culture would use. Usually the two-letter language name, e.g. "fr" for
+	// fr-CA, except for the cultures in the override table
+	FString GetLocaleCodeForCulture( const FCultureRef& Culture );
+
+	// Culture names whose localization files don't use the culture's two-letter language name
+	static const TMap<FString, FString>& GetLocaleCodeOverrides();
+
+	int32 Num() const;
+
+protected:
+	// Lets Find look up a view without making an FString from it
+	struct FLocaleCodeKeyFuncs : TDefaultMapHashableKeyFuncs<FString, FEntry, false>
+	{
+		static bool Matches( const FString& A, const FString& B ) { return A.Equals( B, ESearchCase::IgnoreCase ); }
+		static bool Matches( const FString& A, FStringView B ) { return FStringView( A ).Equals( B, ESearchCase::IgnoreCase ); }
+		static uint32 GetKeyHash( const FString& Key ) { return GetKeyHash( FStringView( Key ) ); }
+		static uint32 GetKeyHash( FStringView Key );
+	};
+
+	mutable FCriticalSection CS;
+	// Keyed by locale code
+	TMap<FString, FEntry, FDefaultSetAllocator, FLocaleCodeKeyFuncs> Entries;
+	// Keyed by culture name
+	TMap<FString, FString> CultureLocaleCodes;
+};
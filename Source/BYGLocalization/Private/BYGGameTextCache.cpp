@@ -0,0 +1,144 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#include "BYGGameTextCache.h"
+#include "BYGLocalizationCoreMinimal.h"
+#include "BYGLocalizationSettings.h"
+#include "BYGStringTableLoader.h"
+
+#include "Internationalization/StringTableCore.h"
+#include "Internationalization/StringTableRegistry.h"
+
+FBYGGameTextCache::FBYGGameTextCache()
+{
+}
+
+FBYGGameTextCache::FBYGGameTextCache( const FName InTableID, const FName InFallbackTableID )
+	: bUseSettings( false )
+{
+	TableIDs[ 0 ] = InTableID;
+	TableIDs[ 1 ] = InFallbackTableID;
+}
+
+FBYGGameTextCache& FBYGGameTextCache::Get()
+{
+	static FBYGGameTextCache Cache;
+	return Cache;
+}
+
+bool FBYGGameTextCache::Find( const FString& Key, FText& OutText )
+{
+	BYG_SCOPE_CYCLE_COUNTER( FindGameText );
+	check( IsInGameThread() );
+
+	RefreshIfStale();
+	return FindInResolvedTables( Key, OutText );
+}
+
+int32 FBYGGameTextCache::FindBatch( const TArray<FString>& Keys, TArray<FText>& OutTexts, TBitArray<>& OutMissing )
+{
+	BYG_SCOPE_CYCLE_COUNTER( FindGameTextBatch );
+	check( IsInGameThread() );
+
+	RefreshIfStale();
+
+	OutTexts.Reset( Keys.Num() );
+	OutTexts.AddDefaulted( Keys.Num() );
+	OutMissing.Init( false, Keys.Num() );
+
+	int32 NumMissing = 0;
+	for ( int32 i = 0; i < Keys.Num(); ++i )
+	{
+		// Keys are separate allocations, start pulling in the next one while we hash this one
+		if ( i + 1 < Keys.Num() )
+		{
+			FPlatformMisc::Prefetch( *Keys[ i + 1 ] );
+		}
+
+		if ( !FindInResolvedTables( Keys[ i ], OutTexts[ i ] ) )
+		{
+			OutMissing[ i ] = true;
+			++NumMissing;
+		}
+	}
+	return NumMissing;
+}
+
+void FBYGGameTextCache::RefreshIfStale()
+{
+	if ( !bResolved || Generation != FBYGStringTableLoader::GetTableGeneration() )
+	{
+		Refresh();
+	}
+}
+
+bool FBYGGameTextCache::FindInResolvedTables( const FString& Key, FText& OutText )
+{
+	BYG_INC_COUNTER( Lookups, 1 );
+
+	if ( const FText* CachedText = Texts.Find( Key ) )
+	{
+		OutText = *CachedText;
+		return true;
+	}
+
+	for ( int32 i = 0; i < UE_ARRAY_COUNT( Tables ); ++i )
+	{
+		if ( Tables[ i ].IsValid() && Tables[ i ]->FindEntry( *Key ).IsValid() )
+		{
+			if ( i > 0 )
+			{
+				BYG_INC_COUNTER( FallbackHits, 1 );
+				// Same as the uncached lookup, but only the first time. After that the key is found in Texts
+				if ( Tables[ 0 ].IsValid() )
+				{
+					UE_LOG( LogBYGLocalization, Error, TEXT( "Could not find key '%s' in string table '%s'" ), *Key, *TableIDs[ 0 ].ToString() );
+				}
+				else
+				{
+					UE_LOG( LogBYGLocalization, Error, TEXT( "Could not find string table '%s'" ), *TableIDs[ 0 ].ToString() );
+				}
+			}
+			// Only tag on the first lookup of a key, tagging every lookup would cost more than the lookup
+			BYG_LLM_SCOPE();
+			OutText = Texts.Add( Key, FText::FromStringTable( TableIDs[ i ], Key ) );
+			return true;
+		}
+	}
+
+	BYG_INC_COUNTER( LookupMisses, 1 );
+	return false;
+}
+
+void FBYGGameTextCache::Reset()
+{
+	bResolved = false;
+	for ( FStringTableConstPtr& Table : Tables )
+	{
+		Table.Reset();
+	}
+	// Not Reset, the old tables could have had far more keys than the new ones
+	Texts.Empty();
+}
+
+void FBYGGameTextCache::Refresh()
+{
+	BYG_SCOPE_CYCLE_COUNTER( RefreshGameTextCache );
+	BYG_LLM_SCOPE();
+
+	Reset();
+
+	if ( bUseSettings )
+	{
+		const UBYGLocalizationSettings* Settings = GetDefault<UBYGLocalizationSettings>();
+		TableIDs[ 0 ] = FName( *Settings->StringtableID );
+		TableIDs[ 1 ] = FName( *Settings->PrimaryLanguageCode );
+	}
+
+	for ( int32 i = 0; i < UE_ARRAY_COUNT( Tables ); ++i )
+	{
+		Tables[ i ] = FStringTableRegistry::Get().FindStringTable( TableIDs[ i ] );
+	}
+
+	Generation = FBYGStringTableLoader::GetTableGeneration();
+	bResolved = true;
+}
@@ -0,0 +1,54 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Internationalization/StringTableCoreFwd.h"
+
+// Lookup cache behind UBYGLocalizationStatics::GetGameText. Game thread only.
+// The string tables are resolved once and kept until FBYGStringTableLoader registers or unregisters a table.
+// Each key found is turned into an FText bound to its string table entry the first time it is asked for, and
+// after that a lookup is one map find and a copy of the cached FText, which doesn't allocate.
+// Keys that are only in the fallback table are logged as errors the first time they are found, like uncached lookups
+class BYGLOCALIZATION_API FBYGGameTextCache
+{
+public:
+	// Looks up keys in the current string table and falls back to the primary language table, both from settings
+	FBYGGameTextCache();
+	// Looks up keys in the given tables instead of the ones from settings
+	FBYGGameTextCache( const FName InTableID, const FName InFallbackTableID );
+
+	static FBYGGameTextCache& Get();
+
+	// Returns false if the key is in neither table, OutText is left untouched
+	bool Find( const FString& Key, FText& OutText );
+
+	// Resolves the tables once for the whole batch. OutTexts has one entry per key, bit i of OutMissing is set if
+	// Keys[ i ] is in neither table and OutTexts[ i ] is left empty. Returns the number of missing keys
+	int32 FindBatch( const TArray<FString>& Keys, TArray<FText>& OutTexts, TBitArray<>& OutMissing );
+
+	void Reset();
+
+protected:
+	void RefreshIfStale();
+	void Refresh();
+	bool FindInResolvedTables( const FString& Key, FText& OutText );
+
+	// String table keys are case-sensitive, the default FString key funcs are not
+	struct FCaseSensitiveKeyFuncs : BaseKeyFuncs<TPair<FString, FText>, FString, false>
+	{
+		static const FString& GetSetKey( const TPair<FString, FText>& Element ) { return Element.Key; }
+		static bool Matches( const FString& A, const FString& B ) { return A.Equals( B, ESearchCase::CaseSensitive ); }
+		static uint32 GetKeyHash( const FString& Key ) { return FCrc::StrCrc32( *Key ); }
+	};
+
+	bool bUseSettings = true;
+	FName TableIDs[ 2 ];
+	FStringTableConstPtr Tables[ 2 ];
+	uint32 Generation = 0;
+	bool bResolved = false;
+
+	// Only keys that were found in the tables, and emptied whenever a table is registered, unregistered or patched,
+	// so it never holds more than the tables do
+	TMap<FString, FText, FDefaultSetAllocator, FCaseSensitiveKeyFuncs> Texts;
+};
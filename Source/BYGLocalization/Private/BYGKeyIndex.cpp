@@ -0,0 +1,82 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#include "BYGKeyIndex.h"
+#include "BYGLocalization.h"
+
+void FBYGKeyIndex::Build( const FBYGLocaleData& Data, TArray<int32>& OutDuplicates )
+{
+	Reset();
+
+	// Power of two with at least twice as many slots as entries, so probe sequences stay short
+	const uint32 NumSlots = FMath::RoundUpToPowerOfTwo( FMath::Max( 2 * Data.Num(), 8 ) );
+	Slots.SetNum( NumSlots );
+	SlotMask = NumSlots - 1;
+
+	for ( int32 i = 0; i < Data.Num(); ++i )
+	{
+		const FStringView Key = Data.GetKey( i );
+		const uint64 KeyHash = HashKey( Key );
+		const int32 SlotIndex = FindSlot( Data, Key, KeyHash );
+		FSlot& Slot = Slots[ SlotIndex ];
+		if ( Slot.Index != INDEX_NONE )
+		{
+			OutDuplicates.Add( i );
+			continue;
+		}
+		Slot.Hash = KeyHash;
+		Slot.Index = i;
+		++NumKeys;
+	}
+}
+
+void FBYGKeyIndex::Reset()
+{
+	Slots.Reset();
+	SlotMask = 0;
+	NumKeys = 0;
+}
+
+int32 FBYGKeyIndex::Find( const FBYGLocaleData& Data, const FStringView& Key, uint64 KeyHash ) const
+{
+	if ( Slots.Num() == 0 )
+		return INDEX_NONE;
+
+	return Slots[ FindSlot( Data, Key, KeyHash ) ].Index;
+}
+
+int32 FBYGKeyIndex::FindSlot( const FBYGLocaleData& Data, const FStringView& Key, uint64 KeyHash ) const
+{
+	// Linear probing. The table is never more than half full so there is always an empty slot to stop at
+	uint32 SlotIndex = static_cast<uint32>( KeyHash ) & SlotMask;
+	while ( true )
+	{
+		const FSlot& Slot = Slots[ SlotIndex ];
+		if ( Slot.Index == INDEX_NONE )
+			return SlotIndex;
+
+		if ( Slot.Hash == KeyHash )
+		{
+			const FStringView SlotKey = Data.GetKey( Slot.Index );
+			if ( SlotKey.Len() == Key.Len() && FCString::Strnicmp( SlotKey.GetData(), Key.GetData(), Key.Len() ) == 0 )
+				return SlotIndex;
+		}
+
+		SlotIndex = ( SlotIndex + 1 ) & SlotMask;
+	}
+}
+
+uint64 FBYGKeyIndex::HashKey( const FStringView& Key )
+{
+	// FNV-1a over the lower-cased characters, so keys that differ only by case hash the same
+	uint64 Hash = 0xcbf29ce484222325ull;
+	for ( int32 i = 0; i < Key.Len(); ++i )
+	{
+		Hash ^= static_cast<uint64>( FChar::ToLower( Key[ i ] ) );
+		Hash *= 0x100000001b3ull;
+	}
+	// FNV leaves the low bits poorly mixed, and those are the ones we use for the slot
+	Hash ^= Hash >> 33;
+	Hash *= 0xff51afd7ed558ccdull;
+	Hash ^= Hash >> 33;
+	return Hash;
+}
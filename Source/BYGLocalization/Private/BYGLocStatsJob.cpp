@@ -0,0 +1,87 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#include "BYGLocStatsJob.h"
+#include "BYGUpdateManifest.h"
+
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+
+TSharedRef<FBYGLocStatsJob, ESPMode::ThreadSafe> FBYGLocStatsJob::Launch( const UBYGLocalization& Loc, const TArray<FString>& Paths, const FBYGStatsCache* Cache )
+{
+	check( IsInGameThread() );
+
+	TSharedRef<FBYGLocStatsJob, ESPMode::ThreadSafe> Job = MakeShareable( new FBYGLocStatsJob( Paths.Num(), *Loc.SettingsProvider->GetSettings() ) );
+
+	if ( Cache )
+	{
+		for ( const FString& Path : Paths )
+		{
+			if ( const FBYGStatsCache::FEntry* Entry = Cache->Find( Path ) )
+			{
+				Job->CachedEntries.Add( Path, *Entry );
+			}
+		}
+	}
+
+	for ( const FString& Path : Paths )
+	{
+		Async( EAsyncExecution::TaskGraph, [Job, Path]()
+		{
+			Job->ProcessFile( Path );
+		} );
+	}
+
+	return Job;
+}
+
+void FBYGLocStatsJob::ProcessFile( const FString& Path )
+{
+	if ( !bCancelled )
+	{
+		FResult Result;
+		Result.Path = Path;
+
+		const FFileStatData StatData = IFileManager::Get().GetStatData( *Path );
+		Result.Size = StatData.FileSize;
+		Result.Timestamp = StatData.ModificationTime;
+
+		// The file may have been touched but kept its contents, e.g. after a source control sync. Only a file of the
+		// same size can match, anything else is read once, by the scan, which hashes what it read
+		const FBYGStatsCache::FEntry* CachedEntry = CachedEntries.Find( Path );
+		const bool bHashed = CachedEntry && CachedEntry->Size == Result.Size && FBYGUpdateManifest::HashFile( Path, Result.Hash );
+		if ( bHashed && CachedEntry->Hash == Result.Hash )
+		{
+			Result.Stats = CachedEntry->Stats;
+			Result.bSucceeded = true;
+			Result.bFromCache = true;
+		}
+		else
+		{
+			Result.bSucceeded = UBYGLocalization::GetLocalizationStats( Path, StatusMatcher, Result.Stats, &bCancelled, bHashed ? nullptr : &Result.Hash );
+		}
+
+		if ( !bCancelled )
+		{
+			Results.Enqueue( MoveTemp( Result ) );
+		}
+	}
+
+	// Only count the file once its result is queued, so Drain never finishes with results still to come
+	NumFinished.Increment();
+}
+
+bool FBYGLocStatsJob::Drain( TFunctionRef<void( const FResult& )> OnResult )
+{
+	check( IsInGameThread() );
+
+	// Read before emptying the queue, anything finished by now has already queued its result
+	const bool bAllFinished = NumFinished.GetValue() == NumFiles;
+
+	FResult Result;
+	while ( Results.Dequeue( Result ) )
+	{
+		OnResult( Result );
+	}
+
+	return bAllFinished;
+}
@@ -0,0 +1,65 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "BYGLocalization/Public/BYGLocalization.h"
+#include "BYGStatsCache.h"
+#include "BYGStatusMatcher.h"
+
+// Gets the stats for a set of localization files on the task graph, one task per file, so they use every core.
+// Results are queued by the worker threads and handed out on the game thread by Drain.
+// Tasks keep the job alive, so it is fine to Cancel and drop it while they are still running. They only use what the
+// job copied when it was launched, so they never touch the UBYGLocalization that launched them.
+class BYGLOCALIZATION_API FBYGLocStatsJob : public TSharedFromThis<FBYGLocStatsJob, ESPMode::ThreadSafe>
+{
+public:
+	struct FResult
+	{
+		FString Path;
+		BYGLocStats Stats;
+		// What the file looked like when it was read, for FBYGStatsCache
+		int64 Size = 0;
+		FDateTime Timestamp;
+		uint64 Hash = 0;
+		// False if the file could not be read or the job was cancelled part-way through it
+		bool bSucceeded = false;
+		// The contents matched the cache so the file wasn't scanned
+		bool bFromCache = false;
+	};
+
+	// Loc's settings are read here, it doesn't need to outlive the job. Must be called on the game thread.
+	// If a cache is given, files whose contents hash the same as their cache entry reuse its stats instead of being scanned
+	static TSharedRef<FBYGLocStatsJob, ESPMode::ThreadSafe> Launch( const UBYGLocalization& Loc, const TArray<FString>& Paths, const FBYGStatsCache* Cache = nullptr );
+
+	// Files that haven't started are skipped and files being scanned stop early. Their results are not queued
+	void Cancel() { bCancelled = true; }
+	bool IsCancelled() const { return bCancelled; }
+
+	// Game thread only. Calls OnResult for everything queued since the last call.
+	// Returns true once every task has finished and all results have been handed out
+	bool Drain( TFunctionRef<void( const FResult& )> OnResult );
+
+	int32 GetNumFiles() const { return NumFiles; }
+	int32 GetNumFinished() const { return NumFinished.GetValue(); }
+
+protected:
+	FBYGLocStatsJob( int32 InNumFiles, const UBYGLocalizationSettings& Settings )
+		: NumFiles( InNumFiles )
+		, StatusMatcher( Settings )
+	{
+	}
+
+	void ProcessFile( const FString& Path );
+
+	const int32 NumFiles;
+	const FBYGStatusMatcher StatusMatcher;
+	// Copied from the cache before any task starts and only read after that
+	TMap<FString, FBYGStatsCache::FEntry> CachedEntries;
+	FThreadSafeBool bCancelled;
+	FThreadSafeCounter NumFinished;
+	TQueue<FResult, EQueueMode::Mpsc> Results;
+};
@@ -1,36 +1,134 @@
 // Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
 
 #include "BYGLocalization.h"
+#include "BYGCSVParser.h"
+#include "BYGCultureCache.h"
+#include "BYGStatusMatcher.h"
+#include "BYGStringTableLoader.h"
+#include "BYGUpdateManifest.h"
 #include "BYGLocalizationCoreMinimal.h"
 #include "BYGLocalizationSettings.h"
 
+#include "Async/ParallelFor.h"
+#include "Dom/JsonObject.h"
 #include "Engine/EngineTypes.h"
 #include "HAL/PlatformFilemanager.h"
+#include "Hash/CityHash.h"
 #include "Internationalization/Regex.h"
 #include "Misc/FileHelper.h"
+#include "Misc/ScopeExit.h"
 #include "Misc/Paths.h"
-#include "Serialization/Csv/CsvParser.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include "Windows/MinWindows.h"
+#include "Windows/HideWindowsPlatformTypes.h"
+#elif PLATFORM_UNIX || PLATFORM_MAC
+#include <unistd.h>
+#endif
 
 FBYGLocaleData::FBYGLocaleData( const TArray<FBYGLocalizationEntry>& NewEntries )
 {
-	QUICK_SCOPE_CYCLE_COUNTER( STAT_BYGLocalization_SetEntriesInOrder );
+	int32 TotalChars = 0;
+	for ( const FBYGLocalizationEntry& Entry : NewEntries )
+	{
+		TotalChars += Entry.Key.Len() + Entry.Translation.Len() + Entry.Comment.Len() + Entry.Primary.Len() + Entry.OldPrimary.Len();
+	}
+	Reserve( NewEntries.Num(), TotalChars );
+
+	for ( const FBYGLocalizationEntry& Entry : NewEntries )
+	{
+		AddEntry( Entry.Key, Entry.Translation, Entry.Comment, Entry.Primary, Entry.OldPrimary, Entry.Status );
+	}
+	BuildIndex();
+}
+
+FBYGLocaleData::FBYGLocaleData( FString&& InText )
+	: Text( MoveTemp( InText ) )
+{
+}
 
-	EntriesInOrder = NewEntries;
-	KeyToIndex.Empty();
+void FBYGLocaleData::Reserve( int32 NumEntries, int32 InNumChars )
+{
+	for ( TArray<FSpan>& FieldSpans : Spans )
+	{
+		FieldSpans.Reserve( NumEntries );
+	}
+	Statuses.Reserve( NumEntries );
+	Text.Reserve( Text.Len() + InNumChars );
+}
 
-	// Update key to index stuff
-	for ( int32 i = 0; i < EntriesInOrder.Num(); ++i )
+int32 FBYGLocaleData::AddEntry( const FStringView& Key, const FStringView& Translation, const FStringView& Comment, const FStringView& Primary, const FStringView& OldPrimary, EBYGLocEntryStatus Status )
+{
+	const FStringView Fields[ NumFields ] = { Key, Translation, Comment, Primary, OldPrimary };
+
+	// Find the views that are already in our text before appending anything, appending can move it
+	const TCHAR* TextStart = Text.GetCharArray().GetData();
+	const TCHAR* TextEnd = TextStart + Text.Len();
+	FSpan NewSpans[ NumFields ];
+	bool bInText[ NumFields ];
+	for ( int32 i = 0; i < NumFields; ++i )
 	{
-		// NO DUPLICATE KEYS
-		if ( KeyToIndex.Contains( EntriesInOrder[ i ].Key ) )
+		const TCHAR* FieldStart = Fields[ i ].GetData();
+		bInText[ i ] = Fields[ i ].Len() == 0 || ( FieldStart >= TextStart && FieldStart + Fields[ i ].Len() <= TextEnd );
+		if ( bInText[ i ] && Fields[ i ].Len() > 0 )
 		{
-			UE_LOG( LogBYGLocalization, Warning, TEXT( "Duplicate key found! Line: %d, Key '%s'" ), i, *EntriesInOrder[ i ].Key );
+			NewSpans[ i ].Offset = static_cast<int32>( FieldStart - TextStart );
+			NewSpans[ i ].Len = Fields[ i ].Len();
 		}
-		else
+	}
+	for ( int32 i = 0; i < NumFields; ++i )
+	{
+		if ( !bInText[ i ] )
 		{
-			KeyToIndex.Add( EntriesInOrder[ i ].Key, i );
+			NewSpans[ i ].Offset = Text.Len();
+			NewSpans[ i ].Len = Fields[ i ].Len();
+			Text.AppendChars( Fields[ i ].GetData(), Fields[ i ].Len() );
 		}
+		Spans[ i ].Add( NewSpans[ i ] );
+		NumChars += NewSpans[ i ].Len;
+	}
+
+	return Statuses.Add( Status );
+}
+
+int32 FBYGLocaleData::AddEntry( const FBYGLocaleData& Other, int32 Index, EBYGLocEntryStatus Status )
+{
+	return AddEntry( Other.GetKey( Index ), Other.GetTranslation( Index ), Other.GetComment( Index ), Other.GetPrimary( Index ), Other.GetOldPrimary( Index ), Status );
+}
+
+void FBYGLocaleData::BuildIndex()
+{
+	BYG_SCOPE_CYCLE_COUNTER( BuildIndex );
+
+	// NO DUPLICATE KEYS
+	DuplicateIndices.Reset();
+	KeyIndex.Build( *this, DuplicateIndices );
+	for ( const int32 i : DuplicateIndices )
+	{
+		UE_LOG( LogBYGLocalization, Warning, TEXT( "Duplicate key found! Line: %d, Key '%s'" ), i, *FBYGCSVParser::ToString( GetKey( i ) ) );
+	}
+}
+
+FBYGLocalizationEntry FBYGLocaleData::GetEntry( int32 Index ) const
+{
+	FBYGLocalizationEntry Entry( FBYGCSVParser::ToString( GetKey( Index ) ), FBYGCSVParser::ToString( GetTranslation( Index ) ), FBYGCSVParser::ToString( GetComment( Index ) ) );
+	Entry.Primary = FBYGCSVParser::ToString( GetPrimary( Index ) );
+	Entry.OldPrimary = FBYGCSVParser::ToString( GetOldPrimary( Index ) );
+	Entry.Status = GetStatus( Index );
+	return Entry;
+}
+
+SIZE_T FBYGLocaleData::GetAllocatedSize() const
+{
+	SIZE_T Size = Text.GetAllocatedSize() + Statuses.GetAllocatedSize() + KeyIndex.GetAllocatedSize() + DuplicateIndices.GetAllocatedSize();
+	for ( const TArray<FSpan>& FieldSpans : Spans )
+	{
+		Size += FieldSpans.GetAllocatedSize();
 	}
+	return Size;
 }
 
 void UBYGLocalization::Construct( TSharedPtr<const IBYGLocalizationSettingsProvider> InSettingsProvider )
@@ -40,46 +138,142 @@ void UBYGLocalization::Construct( TSharedPtr<const IBYGLocalizationSettingsProvi
 
 TArray<FString> UBYGLocalization::GetAllLocalizationFiles() const
 {
+	return *GetLocalizationFilesSnapshot();
+}
+
+UBYGLocalization::FFileListRef UBYGLocalization::GetLocalizationFilesSnapshot() const
+{
+	const FString SettingsKey = GetDiscoverySettingsKey();
+
+	// Other callers wait for the scan rather than starting their own
+	FScopeLock Lock( &DiscoveredFilesCS );
+	if ( !DiscoveredFiles.IsValid() || !SettingsKey.Equals( DiscoveredFilesSettingsKey, ESearchCase::CaseSensitive ) )
+	{
+		DiscoveredFiles = DiscoverLocalizationFiles();
+		DiscoveredFilesSettingsKey = SettingsKey;
+	}
+	return DiscoveredFiles.ToSharedRef();
+}
+
+void UBYGLocalization::InvalidateLocalizationFiles()
+{
+	FScopeLock Lock( &DiscoveredFilesCS );
+	DiscoveredFiles.Reset();
+}
+
+UBYGLocalization::FFileListRef UBYGLocalization::DiscoverLocalizationFiles() const
+{
+	BYG_SCOPE_CYCLE_COUNTER( DiscoverLocalizationFiles );
+	BYG_LLM_SCOPE();
+
 	const UBYGLocalizationSettings* Settings = SettingsProvider->GetSettings();
 
-	TArray<FString> Files;
+	int32 MaxDepth = 0;
+	if ( Settings->bIncludeSubdirectories )
+	{
+		MaxDepth = Settings->MaxSubdirectoryDepth > 0 ? Settings->MaxSubdirectoryDepth : INDEX_NONE;
+	}
+
+	// A slow directory, e.g. Workshop content under the user dir, doesn't hold up the others
+	const TArray<FString> Directories = GetLocalizationDirectories();
+	TArray<TArray<FString>> FilesPerDirectory;
+	FilesPerDirectory.SetNum( Directories.Num() );
+	ParallelFor( Directories.Num(), [this, &Directories, &FilesPerDirectory, MaxDepth]( int32 i )
+	{
+		FindLocalizationFiles( Directories[ i ], MaxDepth, FilesPerDirectory[ i ] );
+	} );
+
+	// Same order as the directories in settings, however long each one took
+	TSharedRef<TArray<FString>, ESPMode::ThreadSafe> Files = MakeShared<TArray<FString>, ESPMode::ThreadSafe>();
+	for ( TArray<FString>& DirectoryFiles : FilesPerDirectory )
+	{
+		Files->Append( MoveTemp( DirectoryFiles ) );
+	}
+	return Files;
+}
+
+void UBYGLocalization::FindLocalizationFiles( const FString& Directory, int32 DepthRemaining, TArray<FString>& OutFiles ) const
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	TArray<FString> Subdirectories;
+	PlatformFile.IterateDirectory( *Directory, [this, &OutFiles, &Subdirectories]( const TCHAR* InFilenameOrDirectory, const bool bIsDir ) -> bool
+	{
+		if ( bIsDir )
+		{
+			Subdirectories.Add( InFilenameOrDirectory );
+		}
+		// Find all .txt/.csv files in a dir
+		else if ( IsLocalizationFile( InFilenameOrDirectory ) )
+		{
+			FString NewPath = InFilenameOrDirectory;
+			FPaths::RemoveDuplicateSlashes( NewPath );
+			FPaths::MakePathRelativeTo( NewPath, *FPaths::ProjectContentDir() );
+			OutFiles.Add( NewPath );
+		}
+		// return true to continue searching
+		return true;
+	} );
+
+	if ( DepthRemaining == 0 )
+		return;
+
+	for ( const FString& Subdirectory : Subdirectories )
+	{
+		FindLocalizationFiles( Subdirectory, DepthRemaining > 0 ? DepthRemaining - 1 : INDEX_NONE, OutFiles );
+	}
+}
+
+FString UBYGLocalization::GetDiscoverySettingsKey() const
+{
+	const UBYGLocalizationSettings* Settings = SettingsProvider->GetSettings();
+
+	FString Key = FString::Printf( TEXT( "%s|%s|%s|%d|%d" ),
+		*Settings->FilenamePrefix,
+		*Settings->FilenameSuffix,
+		*Settings->PrimaryExtension,
+		Settings->bIncludeSubdirectories ? 1 : 0,
+		Settings->MaxSubdirectoryDepth );
+	for ( const FString& Extension : Settings->AllowedExtensions )
+	{
+		Key += TEXT( "|" ) + Extension;
+	}
+	for ( const FString& Directory : GetLocalizationDirectories() )
+	{
+		Key += TEXT( "|" ) + Directory;
+	}
+	return Key;
+}
+
+TArray<FString> UBYGLocalization::GetLocalizationDirectories() const
+{
+	const UBYGLocalizationSettings* Settings = SettingsProvider->GetSettings();
 
 	TArray<FDirectoryPath> Paths = { Settings->PrimaryLocalizationDirectory };
 	for ( const FBYGPath& BYGPath : Settings->AdditionalLocalizationDirectories )
 	{
 		Paths.Add( BYGPath.GetDirectoryPath() );
 	}
+
+	TArray<FString> Directories;
 	for ( const FDirectoryPath& Path : Paths )
 	{
-		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
 		// Directory Path will probably be /Game/Somethingd
 		FString LocalizationDirPath = Path.Path.Replace( TEXT( "/Game" ), *FPaths::ProjectContentDir() );
 		FPaths::RemoveDuplicateSlashes( LocalizationDirPath );
-		bool bFound = false;
-		TArray<FString> LocalFiles;
-		PlatformFile.IterateDirectoryRecursively( *LocalizationDirPath, [&bFound, &PlatformFile, &Files, &Settings]( const TCHAR* InFilenameOrDirectory, const bool bIsDir ) -> bool
-		{
-			// Find all .txt/.csv files in a dir
-			if ( !bIsDir )
-			{
-				const FString BaseName = FPaths::GetBaseFilename( InFilenameOrDirectory );
-				if ( Settings->GetIsValidExtension( FPaths::GetExtension( InFilenameOrDirectory ) )
-					&& ( Settings->FilenamePrefix.IsEmpty() || BaseName.StartsWith( Settings->FilenamePrefix ) )
-					&& ( Settings->FilenameSuffix.IsEmpty() || BaseName.EndsWith( Settings->FilenameSuffix ) ) )
-				{
-					FString NewPath = InFilenameOrDirectory;
-					FPaths::RemoveDuplicateSlashes( NewPath );
-					FPaths::MakePathRelativeTo( NewPath, *FPaths::ProjectContentDir() );
-					Files.Add( NewPath );
-				}
-			}
-			// return true to continue searching
-			return true;
-		} );
-		Files.Append( LocalFiles );
+		Directories.Add( LocalizationDirPath );
 	}
+	return Directories;
+}
 
-	return Files;
+bool UBYGLocalization::IsLocalizationFile( const FString& Filename ) const
+{
+	const UBYGLocalizationSettings* Settings = SettingsProvider->GetSettings();
+
+	const FString BaseName = FPaths::GetBaseFilename( Filename );
+	return Settings->GetIsValidExtension( FPaths::GetExtension( Filename ) )
+		&& ( Settings->FilenamePrefix.IsEmpty() || BaseName.StartsWith( Settings->FilenamePrefix ) )
+		&& ( Settings->FilenameSuffix.IsEmpty() || BaseName.EndsWith( Settings->FilenameSuffix ) );
 }
 
 FString UBYGLocalization::GetFilenameFromLanguageCode( const FString& LanguageCode ) const
@@ -104,45 +298,412 @@ FString UBYGLocalization::GetFileWithPathFromLanguageCode( const FString& Langua
 
 bool UBYGLocalization::UpdateTranslations()
 {
-	QUICK_SCOPE_CYCLE_COUNTER( STAT_BYGLocalization_UpdateTranslations );
+	BYG_SCOPE_CYCLE_COUNTER( UpdateTranslations );
+	BYG_LLM_SCOPE();
+
+	LastUpdateReport = FBYGUpdateReport();
+	LastUpdateMemory = FBYGUpdateMemoryReport();
+	UpdateMemory.Reset();
+	ON_SCOPE_EXIT
+	{
+		LastUpdateMemory.PeakBytes = UpdateMemory.GetPeak();
+	};
 
-	const TArray<FString> Files = GetAllLocalizationFiles();
+	const FFileListRef FileList = GetLocalizationFilesSnapshot();
+	const TArray<FString>& Files = *FileList;
 
 	const UBYGLocalizationSettings* Settings = SettingsProvider->GetSettings();
 
+	const FString PrimaryPath = FBYGStringTableLoader::GetFullPath( GetFileWithPathFromLanguageCode( Settings->PrimaryLanguageCode ) );
+
+	// A locale file only needs updating if it, the primary file or the settings changed since we last wrote it
+	const FString ManifestPath = FBYGUpdateManifest::GetManifestPath( PrimaryPath );
+	// The snapshot is a copy of the primary file as it was when the manifest was written
+	const FString SnapshotPath = FBYGUpdateManifest::GetSnapshotPath( PrimaryPath );
+	FBYGUpdateManifest Manifest;
+	FBYGUpdateManifest::FFile Primary;
+	const uint64 SettingsHash = FBYGUpdateManifest::HashSettings( *Settings );
+	bool bSettingsUnchanged = false;
+	bool bPrimaryUnchanged = false;
+	// Set if saving the manifest would record anything new, even when no file needs merging
+	bool bManifestChanged = false;
+	TMap<FString, FBYGUpdateManifest::FFile> LastWrittenFiles;
+	if ( Settings->bIncrementalUpdate )
+	{
+		Manifest.Load( ManifestPath );
+		bSettingsUnchanged = Manifest.SettingsHash == SettingsHash;
+		bPrimaryUnchanged = FBYGUpdateManifest::IsUnchanged( PrimaryPath, &Manifest.Primary, Primary )
+			&& bSettingsUnchanged;
+		if ( Primary.Hash == 0 )
+		{
+			FBYGUpdateManifest::HashFile( PrimaryPath, Primary.Hash );
+		}
+		bManifestChanged = !bSettingsUnchanged || Primary != Manifest.Primary;
+		LastWrittenFiles = MoveTemp( Manifest.Files );
+		if ( bPrimaryUnchanged )
+		{
+			// Files we skip are still up to date
+			Manifest.Files = LastWrittenFiles;
+		}
+	}
+
+	// Work out sizes up-front so the biggest files get scheduled first and don't end up as the long tail
+	TArray<FString> FullPaths;
+	TArray<int64> FileSizes;
+	TArray<int32> Order;
+	// Files that haven't been touched since we wrote them can have the primary delta applied
+	TBitArray<> bUnchangedSinceWritten( false, Files.Num() );
+	for ( const FString& FileWithPath : Files )
+	{
+		const FString FullPath = FPaths::Combine( FPaths::ProjectContentDir(), FileWithPath );
+		const int32 Index = FullPaths.Add( FullPath );
+
+		// Only files whose size matches but whose modification time doesn't are read
+		FBYGUpdateManifest::FFile File;
+		const FBYGUpdateManifest::FFile* LastWritten = bSettingsUnchanged ? LastWrittenFiles.Find( FileWithPath ) : nullptr;
+		const bool bUnchanged = FBYGUpdateManifest::IsUnchanged( FullPath, LastWritten, File );
+		FileSizes.Add( File.Size );
+
+		// The primary file is never rewritten
+		if ( RemovePrefixSuffix( FileWithPath ) == Settings->PrimaryLanguageCode )
+			continue;
+
+		if ( bUnchanged )
+		{
+			if ( bPrimaryUnchanged )
+			{
+				// Keep the new modification time so the file isn't hashed again next time
+				bManifestChanged |= File != *LastWritten;
+				Manifest.Files.Add( FileWithPath, File );
+				continue;
+			}
+			bUnchangedSinceWritten[ Index ] = true;
+		}
+
+		Order.Add( Index );
+	}
+
+	auto SaveManifest = [&]()
+	{
+		// Keep the snapshot in step with the manifest, otherwise the next delta would be against the wrong primary
+		IFileManager::Get().MakeDirectory( *FPaths::GetPath( SnapshotPath ), true );
+		if ( ( !bPrimaryUnchanged || !FPaths::FileExists( SnapshotPath ) ) && IFileManager::Get().Copy( *SnapshotPath, *PrimaryPath ) != COPY_OK )
+		{
+			IFileManager::Get().Delete( *SnapshotPath );
+		}
+
+		Manifest.Primary = Primary;
+		Manifest.SettingsHash = SettingsHash;
+		if ( !Manifest.Save( ManifestPath ) )
+		{
+			UE_LOG( LogBYGLocalization, Warning, TEXT( "Could not write update manifest '%s'" ), *ManifestPath );
+		}
+	};
+
+	if ( Order.Num() == 0 )
+	{
+		UE_LOG( LogBYGLocalization, Log, TEXT( "All localization files are up to date" ) );
+		// Files that were touched but not changed have new modification times to remember
+		if ( Settings->bIncrementalUpdate && bManifestChanged )
+		{
+			SaveManifest();
+		}
+		return true;
+	}
+
 	FBYGLocaleData PrimaryData;
-	const FString FullFilename = FPaths::Combine( Settings->PrimaryLocalizationDirectory.Path, GetFilenameFromLanguageCode( Settings->PrimaryLanguageCode ) );
-	const bool bSucceeded = GetLocalizationDataFromFile( FullFilename, PrimaryData );
+	const bool bSucceeded = GetLocalizationDataFromFile( PrimaryPath, PrimaryData );
 
 	if ( !bSucceeded )
 	{
 		return false;
 	}
 
-	const TArray<FBYGLocalizationEntry>* PrimaryEntriesInOrder = PrimaryData.GetEntriesInOrder();
-	const TMap<FString, int32>* PrimaryKeyToIndex = PrimaryData.GetKeyToIndex();
-	if ( !ensure( PrimaryEntriesInOrder->Num() > 0 ) )
+	if ( !ensure( PrimaryData.Num() > 0 ) )
 		return false;
 
-	// Source file is Primary
-	for ( const FString& FileWithPath : Files )
+	LastUpdateMemory.NumFiles = Order.Num();
+	LastUpdateMemory.PrimaryBytes = PrimaryData.GetAllocatedSize();
+	UpdateMemory.Add( LastUpdateMemory.PrimaryBytes );
+
+	// Work out what changed in the primary once, rather than rediscovering it for every locale
+	FBYGPrimaryDelta Delta;
+	bool bHasDelta = false;
+	if ( Settings->bIncrementalUpdate && bSettingsUnchanged && bUnchangedSinceWritten.Contains( true ) )
 	{
-		const FString FullPath = FPaths::Combine( FPaths::ProjectContentDir(), FileWithPath );
-		UpdateTranslationFile(FileWithPath, PrimaryEntriesInOrder, PrimaryKeyToIndex );
+		uint64 SnapshotHash = 0;
+		FBYGLocaleData SnapshotData;
+		bHasDelta = FBYGUpdateManifest::HashFile( SnapshotPath, SnapshotHash )
+			&& SnapshotHash == Manifest.Primary.Hash
+			&& GetLocalizationDataFromFile( SnapshotPath, SnapshotData )
+			&& ComputePrimaryDelta( SnapshotData, PrimaryData, Delta );
+
+		// The snapshot is gone once the delta is worked out, the delta stays for the whole update
+		const int64 DeltaBytes = Delta.NewToOld.GetAllocatedSize() + Delta.Added.GetAllocatedSize() + Delta.Modified.GetAllocatedSize()
+			+ Delta.bIsModified.GetAllocatedSize() + Delta.Removed.GetAllocatedSize();
+		UpdateMemory.Add( SnapshotData.GetAllocatedSize() + DeltaBytes );
+		UpdateMemory.Remove( SnapshotData.GetAllocatedSize() );
+		LastUpdateMemory.PrimaryBytes += DeltaBytes;
+		if ( bHasDelta )
+		{
+			UE_LOG( LogBYGLocalization, Log, TEXT( "Primary changes since last update: %d added, %d modified, %d removed" ),
+				Delta.Added.Num(), Delta.Modified.Num(), Delta.Removed.Num() );
+		}
+	}
+
+	Order.StableSort( [&FileSizes]( const int32 A, const int32 B ) { return FileSizes[ A ] > FileSizes[ B ]; } );
+
+	// Each file only reads the primary data so they can all be updated at the same time.
+	// Results are stored per-file and logged afterwards in discovery order, so the log is the same no matter
+	// how the work was split up
+	TArray<FBYGUpdateFileResult> Results;
+	Results.SetNum( FullPaths.Num() );
+
+	const double StartTime = FPlatformTime::Seconds();
+	ParallelFor( Order.Num(), [&]( const int32 i )
+	{
+		const int32 Index = Order[ i ];
+		const FBYGPrimaryDelta* FileDelta = bHasDelta && bUnchangedSinceWritten[ Index ] ? &Delta : nullptr;
+		UpdateTranslationFile( FullPaths[ Index ], PrimaryData, &Results[ Index ], FileDelta );
+	}, !Settings->bParallelUpdate );
+	const double TotalSeconds = FPlatformTime::Seconds() - StartTime;
+
+	int32 NumUpdated = 0;
+	int32 NumWritten = 0;
+	BYGLocStats NumChangedKeys;
+	LastUpdateReport.Files.Reserve( Order.Num() );
+	for ( int32 i = 0; i < Results.Num(); ++i )
+	{
+		FBYGUpdateFileResult& Result = Results[ i ];
+		Result.Flush();
+		if ( Result.bUpdated )
+		{
+			++NumUpdated;
+			// What is on disk now, whether or not we had to write it
+			if ( Settings->bIncrementalUpdate )
+			{
+				FBYGUpdateManifest::FFile File;
+				FBYGUpdateManifest::StatFile( FullPaths[ i ], File );
+				File.Hash = Result.Hash;
+				Manifest.Files.Add( Files[ i ], File );
+			}
+		}
+		if ( Result.bWritten )
+		{
+			++NumWritten;
+		}
+		for ( int32 Status = 0; Status < BYGLocStats::NumStatuses; ++Status )
+		{
+			NumChangedKeys.Counts[ Status ] += Result.ChangedKeys[ Status ].Num();
+		}
+
+		// Files that weren't in Order were skipped and have no result
+		if ( !Result.Path.IsEmpty() )
+		{
+			LastUpdateReport.Files.Add( MoveTemp( Result ) );
+		}
+	}
+	UE_LOG( LogBYGLocalization, Log, TEXT( "Updated %d of %d localization files in %.1f ms (%s), %d written, %d already up to date" ),
+		NumUpdated, Order.Num(), TotalSeconds * 1000.0, Settings->bParallelUpdate ? TEXT( "parallel" ) : TEXT( "serial" ),
+		NumWritten, NumUpdated - NumWritten );
+	UE_LOG( LogBYGLocalization, Log, TEXT( "Keys changed in all locales: %d added, %d modified, %d deprecated" ),
+		NumChangedKeys[ EBYGLocEntryStatus::New ], NumChangedKeys[ EBYGLocEntryStatus::Modified ], NumChangedKeys[ EBYGLocEntryStatus::Deprecated ] );
+	if ( Settings->UpdateReportFormat != EBYGUpdateReportFormat::None )
+	{
+		const FString ReportPath = FBYGUpdateReport::GetDefaultPath( Settings->UpdateReportFormat );
+		if ( LastUpdateReport.Save( ReportPath, Settings->UpdateReportFormat ) )
+		{
+			UE_LOG( LogBYGLocalization, Log, TEXT( "Wrote update report to '%s'" ), *ReportPath );
+		}
+		else
+		{
+			UE_LOG( LogBYGLocalization, Warning, TEXT( "Could not write update report '%s'" ), *ReportPath );
+		}
+	}
+	UE_LOG( LogBYGLocalization, Log, TEXT( "Update peak memory %.2f MB, %.2f MB of it primary data" ),
+		UpdateMemory.GetPeak() / ( 1024.0 * 1024.0 ), LastUpdateMemory.PrimaryBytes / ( 1024.0 * 1024.0 ) );
+
+	if ( Settings->bIncrementalUpdate )
+	{
+		SaveManifest();
+	}
+
+	return true;
+}
+
+int32 FBYGUpdateFileResult::GetNumChangedKeys() const
+{
+	int32 NumKeys = 0;
+	for ( const TArray<FString>& Keys : ChangedKeys )
+	{
+		NumKeys += Keys.Num();
+	}
+	return NumKeys;
+}
+
+void FBYGUpdateFileResult::Flush() const
+{
+	for ( const FString& Warning : Warnings )
+	{
+		UE_LOG( LogBYGLocalization, Warning, TEXT( "%s" ), *Warning );
+	}
+	// One line per locale, a big change to the primary file would otherwise log every key of every locale
+	if ( GetNumChangedKeys() > 0 )
+	{
+		UE_LOG( LogBYGLocalization, Log, TEXT( "%s: %d keys added, %d modified, %d deprecated" ), *Culture,
+			GetChangedKeys( EBYGLocEntryStatus::New ).Num(), GetChangedKeys( EBYGLocEntryStatus::Modified ).Num(), GetChangedKeys( EBYGLocEntryStatus::Deprecated ).Num() );
+	}
+	for ( const FString& Message : VerboseMessages )
+	{
+		UE_LOG( LogBYGLocalization, Verbose, TEXT( "%s" ), *Message );
+	}
+	if ( bWritten )
+	{
+		UE_LOG( LogBYGLocalization, Log, TEXT( "Updated '%s' in %.1f ms" ), *Path, Seconds * 1000.0 );
+	}
+	else if ( bUpdated )
+	{
+		UE_LOG( LogBYGLocalization, Verbose, TEXT( "'%s' was already up to date (%.1f ms)" ), *Path, Seconds * 1000.0 );
+	}
+}
+
+void UBYGLocalization::MergeEntry( const FBYGLocaleData& PrimaryData, int32 PrimaryIndex, const FBYGLocaleData& LocalData, int32 LocalIndex, const FString& CultureName, FBYGUpdateFileResult& Result, FBYGLocaleData& OutData )
+{
+	const FStringView PrimaryKey = PrimaryData.GetKey( PrimaryIndex );
+	const FStringView PrimaryText = PrimaryData.GetTranslation( PrimaryIndex );
+
+	// A missing entry is all empty
+	const bool bHasLocal = LocalIndex != INDEX_NONE;
+	const FStringView OldKey = bHasLocal ? LocalData.GetKey( LocalIndex ) : FStringView();
+	const FStringView OldTranslation = bHasLocal ? LocalData.GetTranslation( LocalIndex ) : FStringView();
+	const FStringView OldComment = bHasLocal ? LocalData.GetComment( LocalIndex ) : FStringView();
+	const FStringView OldPrimary = bHasLocal ? LocalData.GetPrimary( LocalIndex ) : FStringView();
+	const FStringView OldOldPrimary = bHasLocal ? LocalData.GetOldPrimary( LocalIndex ) : FStringView();
+	const EBYGLocEntryStatus OldStatus = bHasLocal ? LocalData.GetStatus( LocalIndex ) : EBYGLocEntryStatus::None;
+
+	if ( OldTranslation.IsEmpty() && !PrimaryText.IsEmpty() )
+	{
+		Result.AddChangedKey( EBYGLocEntryStatus::New, PrimaryKey );
+		if ( UE_LOG_ACTIVE( LogBYGLocalization, Verbose ) )
+		{
+			Result.VerboseMessages.Add( FString::Printf( TEXT( "%s missing key '%s', adding." ), *CultureName, *FBYGCSVParser::ToString( PrimaryKey ) ) );
+		}
+		// We want to show Primary until they replace the new key with a correct translation, so for now just write in the Primary to the translation field
+		FStringView Translation = PrimaryText;
+		if ( PrimaryKey.Equals( TEXT( "_LocMeta_Author" ), ESearchCase::IgnoreCase ) )
+		{
+			// Don't copy across author "Brace Yourself Games" for updated translations
+			Translation = TEXT( "Unknown" );
+		}
+		OutData.AddEntry( PrimaryKey, Translation, FStringView(), PrimaryText, FStringView(), EBYGLocEntryStatus::New );
+	}
+	// The display text in the master Primary is not the same as the Primary in the localization, something was modified
+	else if ( !OldPrimary.Equals( PrimaryText, ESearchCase::IgnoreCase ) )
+	{
+		if ( !OldPrimary.IsEmpty() )
+		{
+			Result.AddChangedKey( EBYGLocEntryStatus::Modified, PrimaryKey );
+			if ( UE_LOG_ACTIVE( LogBYGLocalization, Verbose ) )
+			{
+				Result.VerboseMessages.Add( FString::Printf( TEXT( "Lang %s: Modified key '%s'. Was '%s', now is '%s'" ), *CultureName,
+					*FBYGCSVParser::ToString( PrimaryKey ), *FBYGCSVParser::ToString( OldPrimary ), *FBYGCSVParser::ToString( PrimaryText ) ) );
+			}
+			OutData.AddEntry( OldKey, OldTranslation, OldComment, PrimaryText, OldPrimary, EBYGLocEntryStatus::Modified );
+		}
+		else
+		{
+			OutData.AddEntry( OldKey, OldTranslation, OldComment, PrimaryText, OldOldPrimary, OldStatus );
+		}
+	}
+	else
+	{
+		OutData.AddEntry( OldKey, OldTranslation, OldComment, OldPrimary, OldOldPrimary, OldStatus );
+	}
+}
+
+void UBYGLocalization::DeprecateEntry( const FBYGLocaleData& LocalData, int32 LocalIndex, const FString& CultureName, FBYGUpdateFileResult& Result, FBYGLocaleData& OutData )
+{
+	// TODO
+	Result.AddChangedKey( EBYGLocEntryStatus::Deprecated, LocalData.GetKey( LocalIndex ) );
+	if ( UE_LOG_ACTIVE( LogBYGLocalization, Verbose ) )
+	{
+		Result.VerboseMessages.Add( FString::Printf( TEXT( "%s has unused key '%s', marking deprecated." ), *CultureName, *FBYGCSVParser::ToString( LocalData.GetKey( LocalIndex ) ) ) );
+	}
+	OutData.AddEntry( LocalData, LocalIndex, EBYGLocEntryStatus::Deprecated );
+}
+
+bool UBYGLocalization::ComputePrimaryDelta( const FBYGLocaleData& OldPrimary, const FBYGLocaleData& NewPrimary, FBYGPrimaryDelta& OutDelta )
+{
+	BYG_SCOPE_CYCLE_COUNTER( ComputePrimaryDelta );
+
+	// Entries are matched up by key, so this only works if every key is unique
+	if ( OldPrimary.HasDuplicateKeys() || NewPrimary.HasDuplicateKeys() )
+		return false;
+
+	OutDelta = FBYGPrimaryDelta();
+	OutDelta.NumOldEntries = OldPrimary.Num();
+	OutDelta.NewToOld.SetNumUninitialized( NewPrimary.Num() );
+	OutDelta.bIsModified.Init( false, NewPrimary.Num() );
+	OutDelta.bSameKeyOrder = OldPrimary.Num() == NewPrimary.Num();
+
+	for ( int32 i = 0; i < NewPrimary.Num(); ++i )
+	{
+		const int32 OldIndex = OldPrimary.FindIndex( NewPrimary.GetKey( i ) );
+		OutDelta.NewToOld[ i ] = OldIndex;
+		if ( OldIndex == INDEX_NONE )
+		{
+			OutDelta.Added.Add( i );
+			OutDelta.bSameKeyOrder = false;
+			continue;
+		}
+		if ( OldIndex != i )
+		{
+			OutDelta.bSameKeyOrder = false;
+		}
+		if ( !OldPrimary.GetTranslation( OldIndex ).Equals( NewPrimary.GetTranslation( i ), ESearchCase::CaseSensitive ) )
+		{
+			OutDelta.bIsModified[ i ] = true;
+			OutDelta.Modified.Add( i );
+		}
+	}
+
+	for ( int32 i = 0; i < OldPrimary.Num(); ++i )
+	{
+		if ( !NewPrimary.Contains( OldPrimary.GetKey( i ) ) )
+		{
+			OutDelta.Removed.Add( i );
+			OutDelta.bSameKeyOrder = false;
+		}
 	}
 
 	return true;
 }
 
 bool UBYGLocalization::UpdateTranslationFile( const FString& Path,
-	const TArray<FBYGLocalizationEntry>* PrimaryEntriesInOrder,
-	const TMap<FString, int32>* PrimaryKeyToIndex )
+	const FBYGLocaleData& PrimaryData,
+	FBYGUpdateFileResult* OutResult,
+	const FBYGPrimaryDelta* Delta )
 {
-	QUICK_SCOPE_CYCLE_COUNTER( STAT_BYGLocalization_UpdateTranslationFile );
+	BYG_SCOPE_CYCLE_COUNTER( UpdateTranslationFile );
+	BYG_LLM_SCOPE();
+
+	// When nobody is collecting results we log as soon as we're done
+	FBYGUpdateFileResult LocalResult;
+	FBYGUpdateFileResult& Result = OutResult ? *OutResult : LocalResult;
+	ON_SCOPE_EXIT
+	{
+		if ( !OutResult )
+		{
+			LocalResult.Flush();
+		}
+	};
+	Result.Path = Path;
+	const double StartTime = FPlatformTime::Seconds();
 
 	// Source file is Primary
 	const UBYGLocalizationSettings* Settings = SettingsProvider->GetSettings();
 	const FString CultureName = RemovePrefixSuffix( Path );
+	Result.Culture = CultureName;
 
 	if ( CultureName == Settings->PrimaryLanguageCode )
 		return false;
@@ -153,246 +714,338 @@ bool UBYGLocalization::UpdateTranslationFile( const FString& Path,
 	const FFileStatData StatData = PlatformFile.GetStatData( *Path );
 	if ( StatData.bIsValid && StatData.bIsReadOnly )
 	{
-		UE_LOG( LogBYGLocalization, Warning, TEXT( "Cannot write to read-only file" ) );
+		Result.Warnings.Add( FString::Printf( TEXT( "Cannot write to read-only file '%s'" ), *Path ) );
 		return false;
 	}
 
 	FBYGLocaleData LocalData;
-	const bool bSucceeded = GetLocalizationDataFromFile( Path, LocalData );
+	uint64 LocalHash = 0;
+	const bool bSucceeded = GetLocalizationDataFromFile( Path, LocalData, &LocalHash );
 	if ( !bSucceeded )
 		return false;
-	const TArray<FBYGLocalizationEntry>* LocalEntriesInOrder = LocalData.GetEntriesInOrder();
-	const TMap<FString, int32>* LocalKeyToIndex = LocalData.GetKeyToIndex();
+	const int64 LocalBytes = LocalData.GetAllocatedSize();
+	UpdateMemory.Add( LocalBytes );
+	ON_SCOPE_EXIT
+	{
+		UpdateMemory.Remove( LocalBytes );
+	};
 	// Find any keys that are missing
-	if ( LocalEntriesInOrder->Num() == 0 )
+	if ( LocalData.Num() == 0 )
 	{
-		UE_LOG( LogBYGLocalization, Warning, TEXT( "No Entries found when loading %s" ), *Path );
+		Result.Warnings.Add( FString::Printf( TEXT( "No Entries found when loading %s" ), *Path ) );
 	}
 
-	// Will reorder to match
-	TArray<FBYGLocalizationEntry> NewEntriesInOrder;
+	// Will reorder to match. Merged text is copied into one buffer, most of it from the locale file
+	FBYGLocaleData NewData;
+	NewData.Reserve( PrimaryData.Num() + LocalData.Num(), LocalData.GetNumChars() + PrimaryData.GetNumChars() );
 
-	for ( const FBYGLocalizationEntry& PrimaryEntry : *PrimaryEntriesInOrder )
+	// The delta is only valid if this file is exactly what we wrote last time, i.e. its entries are in the order of
+	// the previous primary file followed by any deprecated entries
+	const int32 NumOldPrimary = Delta ? Delta->NumOldEntries : 0;
+	if ( Delta && LocalData.Num() >= NumOldPrimary && Delta->NewToOld.Num() == PrimaryData.Num() )
 	{
-		FBYGLocalizationEntry OldLocalizedEntry;
-		if ( LocalKeyToIndex->Contains( PrimaryEntry.Key )
-			&& (*LocalKeyToIndex)[ PrimaryEntry.Key ] >= 0
-			&& (*LocalKeyToIndex)[ PrimaryEntry.Key ] < LocalEntriesInOrder->Num() )
-		{
-			OldLocalizedEntry = (*LocalEntriesInOrder)[ (*LocalKeyToIndex)[ PrimaryEntry.Key ] ];
-		}
-
-		FBYGLocalizationEntry NewLocalizedEntry;
-		NewLocalizedEntry.Key = PrimaryEntry.Key;
-		NewLocalizedEntry.Primary = PrimaryEntry.Translation;
+		BYG_SCOPE_CYCLE_COUNTER( ApplyPrimaryDelta );
 
-		if ( OldLocalizedEntry.Translation.IsEmpty() && !PrimaryEntry.Translation.IsEmpty() )
+		if ( Delta->bSameKeyOrder )
 		{
-			UE_LOG( LogBYGLocalization, Warning, TEXT( "%s missing key '%s', adding." ), *CultureName, *PrimaryEntry.Key );
-			// We want to show Primary until they replace the new key with a correct translation, so for now just write in the Primary to the translation field
-			NewLocalizedEntry.Translation = PrimaryEntry.Translation;
-			if ( NewLocalizedEntry.Key == "_LocMeta_Author" )
+			// Only the modified entries need to go through the merge rules, everything else is already correct.
+			// With the same set of keys, everything past the primary entries was already deprecated
+			for ( int32 i = 0; i < LocalData.Num(); ++i )
 			{
-				// Don't copy across author "Brace Yourself Games" for updated translations
-				NewLocalizedEntry.Translation = "Unknown";
+				if ( i >= NumOldPrimary )
+				{
+					DeprecateEntry( LocalData, i, CultureName, Result, NewData );
+				}
+				else if ( Delta->bIsModified[ i ] )
+				{
+					MergeEntry( PrimaryData, i, LocalData, i, CultureName, Result, NewData );
+				}
+				else
+				{
+					NewData.AddEntry( LocalData, i );
+				}
 			}
-			NewLocalizedEntry.Status = EBYGLocEntryStatus::New;
 		}
-		// The display text in the master Primary is not the same as the Primary in the localization, something was modified
-		else if ( OldLocalizedEntry.Primary != PrimaryEntry.Translation )
+		else
 		{
-			NewLocalizedEntry = OldLocalizedEntry;
-			NewLocalizedEntry.Primary = PrimaryEntry.Translation;
-			const FString OldPrimary = OldLocalizedEntry.Primary;
-			if ( !OldPrimary.IsEmpty() )
+			for ( int32 i = 0; i < PrimaryData.Num(); ++i )
+			{
+				const int32 OldIndex = Delta->NewToOld[ i ];
+				if ( OldIndex == INDEX_NONE )
+				{
+					// Added keys might still exist as deprecated entries at the end of the file
+					MergeEntry( PrimaryData, i, LocalData, LocalData.FindIndex( PrimaryData.GetKey( i ) ), CultureName, Result, NewData );
+				}
+				else if ( Delta->bIsModified[ i ] )
+				{
+					MergeEntry( PrimaryData, i, LocalData, OldIndex, CultureName, Result, NewData );
+				}
+				else
+				{
+					NewData.AddEntry( LocalData, OldIndex );
+				}
+			}
+
+			// Same order as the full merge would find them: removed keys in old primary order, then the old deprecated entries
+			for ( const int32 OldIndex : Delta->Removed )
+			{
+				DeprecateEntry( LocalData, OldIndex, CultureName, Result, NewData );
+			}
+			for ( int32 i = NumOldPrimary; i < LocalData.Num(); ++i )
 			{
-				UE_LOG( LogBYGLocalization, Warning, TEXT( "Lang %s: Modified key '%s'. Was '%s', now is '%s'" ), *CultureName, *PrimaryEntry.Key, *OldPrimary, *PrimaryEntry.Translation );
-				NewLocalizedEntry.Status = EBYGLocEntryStatus::Modified;
-				NewLocalizedEntry.OldPrimary = OldPrimary;
+				if ( !PrimaryData.Contains( LocalData.GetKey( i ) ) )
+				{
+					DeprecateEntry( LocalData, i, CultureName, Result, NewData );
+				}
 			}
 		}
-		else
+	}
+	else
+	{
+		for ( int32 i = 0; i < PrimaryData.Num(); ++i )
 		{
-			NewLocalizedEntry = OldLocalizedEntry;
+			// One probe per key, the index only ever holds valid entry indices
+			MergeEntry( PrimaryData, i, LocalData, LocalData.FindIndex( PrimaryData.GetKey( i ) ), CultureName, Result, NewData );
 		}
 
-		NewEntriesInOrder.Add( NewLocalizedEntry );
-
-	}
-
-	for ( const FBYGLocalizationEntry& Entry : *LocalEntriesInOrder )
-	{
-		if ( !PrimaryKeyToIndex->Contains( Entry.Key ) )
+		for ( int32 i = 0; i < LocalData.Num(); ++i )
 		{
-			// TODO
-			UE_LOG( LogBYGLocalization, Warning, TEXT( "%s has unused key '%s', marking deprecated." ), *CultureName, *Entry.Key );
-			FBYGLocalizationEntry NewEntry = Entry;
-			NewEntry.Status = EBYGLocEntryStatus::Deprecated;
-			NewEntriesInOrder.Add( NewEntry );
+			if ( !PrimaryData.Contains( LocalData.GetKey( i ) ) )
+			{
+				DeprecateEntry( LocalData, i, CultureName, Result, NewData );
+			}
 		}
 	}
 
-	// Output the file
-	WriteCSV( NewEntriesInOrder, Path );
+	const int64 NewBytes = NewData.GetAllocatedSize();
+	UpdateMemory.Add( NewBytes );
+	ON_SCOPE_EXIT
+	{
+		UpdateMemory.Remove( NewBytes );
+	};
+
+	// Output the file, unless it already has this content
+	Result.bUpdated = WriteCSV( NewData, Path, &Result.bWritten, &Result.Hash, &LocalHash );
+	Result.Seconds = FPlatformTime::Seconds() - StartTime;
 
 	return true;
 }
 
-// Load CSV file into our data structure for ease of use
-bool UBYGLocalization::GetLocalizationDataFromFile( const FString& Filename, FBYGLocaleData& Data ) const
+namespace BYGCSVReading
 {
-	QUICK_SCOPE_CYCLE_COUNTER( STAT_BYGLocalization_GetLocalizationData );
+	// Every row ends in a line break, quoted line breaks only make this an overestimate
+	template <typename CharType>
+	static int32 CountLines( const CharType* Text, int32 Len )
+	{
+		int32 NumLines = 1;
+		for ( int32 i = 0; i < Len; ++i )
+		{
+			NumLines += Text[ i ] == '\n';
+		}
+		return NumLines;
+	}
 
-	const UBYGLocalizationSettings* Settings = SettingsProvider->GetSettings();
+	// Length of a settings string in the parser's characters
+	template <typename CharType>
+	int32 GetLen( const FString& Str );
+	template <>
+	int32 GetLen<TCHAR>( const FString& Str ) { return Str.Len(); }
+	template <>
+	int32 GetLen<ANSICHAR>( const FString& Str ) { return FTCHARToUTF8( *Str, Str.Len() ).Length(); }
 
-	TArray<FBYGLocalizationEntry> NewEntries;
+	// Wide cells are already in the data's text and stay where they are
+	static void AddEntry( FBYGLocaleData& Data, const FStringView& Key, const FStringView& Translation, const FStringView& Comment, const FStringView& Primary, const FStringView& OldPrimary, EBYGLocEntryStatus Status )
+	{
+		Data.AddEntry( Key, Translation, Comment, Primary, OldPrimary, Status );
+	}
+
+	// UTF-8 cells are converted straight onto the end of the data's text, one cell at a time
+	static void AddEntry( FBYGLocaleData& Data, const TStringView<ANSICHAR>& Key, const TStringView<ANSICHAR>& Translation, const TStringView<ANSICHAR>& Comment,
+		const TStringView<ANSICHAR>& Primary, const TStringView<ANSICHAR>& OldPrimary, EBYGLocEntryStatus Status )
+	{
+		const FUTF8ToTCHAR WideKey( Key.GetData(), Key.Len() );
+		const FUTF8ToTCHAR WideTranslation( Translation.GetData(), Translation.Len() );
+		const FUTF8ToTCHAR WideComment( Comment.GetData(), Comment.Len() );
+		const FUTF8ToTCHAR WidePrimary( Primary.GetData(), Primary.Len() );
+		const FUTF8ToTCHAR WideOldPrimary( OldPrimary.GetData(), OldPrimary.Len() );
+		Data.AddEntry( FStringView( WideKey.Get(), WideKey.Length() ), FStringView( WideTranslation.Get(), WideTranslation.Length() ),
+			FStringView( WideComment.Get(), WideComment.Length() ), FStringView( WidePrimary.Get(), WidePrimary.Length() ),
+			FStringView( WideOldPrimary.Get(), WideOldPrimary.Length() ), Status );
+	}
 
-	FString CSVString;
-	if ( FFileHelper::LoadFileToString( CSVString, *Filename ) )
+	// Validates the header then adds every row to Data
+	template <typename CharType>
+	static bool ParseLocaleData( TBYGCSVParser<CharType>& Parser, const FString& Filename, const UBYGLocalizationSettings& Settings, FBYGLocaleData& Data )
 	{
-		const FCsvParser Parser( CSVString );
-		const FCsvParser::FRows& Rows = Parser.GetRows();
+		typedef TBYGCSVParser<CharType> FParser;
+		typedef typename FParser::FCellView FCellView;
+
+		const FBYGStatusMatcher StatusMatcher( Settings );
+		const int32 ModifiedLeftLen = GetLen<CharType>( Settings.ModifiedStatusLeft );
+		const int32 ModifiedRightLen = GetLen<CharType>( Settings.ModifiedStatusRight );
+
+		typename FParser::FRow Row;
 
 		// Validate the header here. Unreal does it for us but we want nicer error-messages
-		bool bValidHeader = true;
-		if ( Rows.Num() > 0 )
+		if ( Parser.ParseRow( Row ) )
 		{
+			bool bValidHeader = true;
 			//Key,SourceString,Comment,Primary,Status
-			if ( !Rows[ 0 ].IsValidIndex( 0 ) || FString( Rows[ 0 ][ 0 ] ) != TEXT( "Key" ) )
+			if ( !Row.IsValidIndex( 0 ) || !FParser::ToString( Row[ 0 ] ).Equals( TEXT( "Key" ), ESearchCase::IgnoreCase ) )
 			{
 				UE_LOG( LogBYGLocalization, Error, TEXT( "Column 0 in header must be 'Key'" ) );
 				bValidHeader = false;
 			}
-			if ( !Rows[ 0 ].IsValidIndex( 1 ) || FString( Rows[ 0 ][ 1 ] ) != TEXT( "SourceString" ) )
+			if ( !Row.IsValidIndex( 1 ) || !FParser::ToString( Row[ 1 ] ).Equals( TEXT( "SourceString" ), ESearchCase::IgnoreCase ) )
 			{
 				UE_LOG( LogBYGLocalization, Error, TEXT( "Column 1 in header must be 'SourceString'" ) );
 				bValidHeader = false;
 			}
+			if ( !bValidHeader )
+				return false;
 		}
-		if ( !bValidHeader )
-			return false;
 
 		// Note that we skip the header
-		for ( int32 i = 1; i < Rows.Num(); ++i )
+		while ( Parser.ParseRow( Row ) )
 		{
-			const TArray<const TCHAR*>& Row = Rows[ i ];
-			if ( Row.Num() < 2 || FString( Row[ 0 ] ) == "" )
+			if ( Parser.HasUnterminatedQuote() && Settings.bWarnOnQuoteFail )
+			{
+				UE_LOG( LogBYGLocalization, Warning, TEXT( "%s line %d: Possible runaway quotation mark, quoted cell runs to the end of the file" ), *Filename, Parser.GetLineNumber() );
+			}
+
+			if ( Row.Num() < 2 || Row[ 0 ].Len() == 0 )
 			{
 				// Add dummy/empty
-			// TODO why?
-				NewEntries.Add( FBYGLocalizationEntry() );
+				// TODO why?
+				AddEntry( Data, FCellView(), FCellView(), FCellView(), FCellView(), FCellView(), EBYGLocEntryStatus::None );
 				continue;
 			}
 
 			// Key,Translation,Comment,Primary,Status
-
 			// Not everything has a comment
-			const FString Comment = ( Row.Num() >= 3 ? FString( Row[ 2 ] ) : "" ); //.ReplaceEscapedCharWithChar();
-
-			const FString Key = FString( Row[ 0 ] ); //.ReplaceEscapedCharWithChar();
-			const FString Translation = FString( Row[ 1 ] ); //.ReplaceEscapedCharWithChar();
-
-#if 0
-			const FRegexPattern RunawayKeyPattern( TEXT( "\n[A-Za-z0-9]+_[A-Za-z0-9_]+," ) );
-			FRegexMatcher RunawayMatcher( RunawayKeyPattern, Translation );
-			if ( RunawayMatcher.FindNext() )
+			const FCellView Comment = Row.Num() >= 3 ? Row[ 2 ] : FCellView();
+			FCellView Primary;
+			FCellView OldPrimary;
+			EBYGLocEntryStatus Status = EBYGLocEntryStatus::None;
+			if ( Row.Num() >= 5 )
 			{
-				UE_LOG( LogBYGLocalization, Warning, TEXT( "Row %d: Possible runaway quotation mark '%s'" ), i, *Key );
+				Primary = Row[ 3 ];
+				Status = StatusMatcher.Classify( Row[ 4 ] );
+				if ( Status == EBYGLocEntryStatus::Modified )
+				{
+					OldPrimary = Row[ 4 ].RightChop( ModifiedLeftLen ).LeftChop( ModifiedRightLen );
+				}
 			}
-#endif
+			AddEntry( Data, Row[ 0 ], Row[ 1 ], Comment, Primary, OldPrimary, Status );
+		}
 
-			FBYGLocalizationEntry Entry( Key, Translation, Comment );
-			if ( Row.Num() >= 5 )
-			{
-				Entry.Primary = FString( Row[ 3 ] ); //.ReplaceEscapedCharWithChar();
+		return true;
+	}
 
+	// Only the Status column is looked at. Returns false if cancelled
+	template <typename CharType>
+	static bool CountStatuses( TBYGCSVParser<CharType>& Parser, const FBYGStatusMatcher& StatusMatcher, BYGLocStats& StatusCounts, const FThreadSafeBool* bCancelled )
+	{
+		// Key,SourceString,Comment,Primary,Status
+		static const int32 StatusColumn = 4;
 
-				const FString Status( Row[ 4 ] );
+		typename TBYGCSVParser<CharType>::FCellView Status;
+		int32 NumCells = 0;
 
-				if ( Status.StartsWith( Settings->DeprecatedStatus ) )
-				{
-					Entry.Status = EBYGLocEntryStatus::Deprecated;
-				}
-				else if ( Status.StartsWith( Settings->ModifiedStatusLeft ) )
-				{
-					Entry.Status = EBYGLocEntryStatus::Modified;
-					Entry.OldPrimary = Status.RightChop( Settings->ModifiedStatusLeft.Len() ).LeftChop( Settings->ModifiedStatusRight.Len() );
-				}
-				else if ( Status.StartsWith( Settings->NewStatus ) )
-				{
-					Entry.Status = EBYGLocEntryStatus::New;
-				}
-				else
-				{
-					Entry.Status = EBYGLocEntryStatus::None;
-				}
+		// Note that we skip the header
+		Parser.ScanRow( StatusColumn, Status, NumCells );
+		int32 NumRows = 0;
+		while ( Parser.ScanRow( StatusColumn, Status, NumCells ) )
+		{
+			++NumRows;
+			if ( NumCells > StatusColumn )
+			{
+				StatusCounts[ StatusMatcher.Classify( Status ) ] += 1;
 			}
-			NewEntries.Add( Entry );
+
+			// Checking every row would cost more than the scan itself
+			if ( bCancelled && ( NumRows & 1023 ) == 0 && *bCancelled )
+				return false;
 		}
+
+		BYG_INC_COUNTER( RowsParsed, NumRows );
+		return true;
 	}
-	else
+}
+
+// Load CSV file into our data structure for ease of use
+bool UBYGLocalization::GetLocalizationDataFromFile( const FString& Filename, FBYGLocaleData& Data, uint64* OutHash ) const
+{
+	BYG_SCOPE_CYCLE_COUNTER( GetLocalizationData );
+	BYG_LLM_SCOPE();
+
+	const UBYGLocalizationSettings* Settings = SettingsProvider->GetSettings();
+
+	FBYGFileText File;
+	if ( !File.Load( *Filename, 0, OutHash ) )
 	{
 		UE_LOG( LogBYGLocalization, Error, TEXT( "Failed to load file '%s'" ), *Filename );
 		return false;
 	}
 
-	Data = FBYGLocaleData( NewEntries );
+	FBYGLocaleData NewData;
+	bool bParsed = false;
+	if ( File.IsUTF8() )
+	{
+		// Only the cells we keep are converted, straight into the data's text. A UTF-8 file never has fewer
+		// bytes than it has TCHARs, so the text is allocated once
+		FBYGUTF8CSVParser Parser( File.GetUTF8(), File.GetUTF8Len() );
+		NewData.Reserve( BYGCSVReading::CountLines( File.GetUTF8(), File.GetUTF8Len() ), File.GetUTF8Len() );
+		bParsed = BYGCSVReading::ParseLocaleData( Parser, Filename, *Settings, NewData );
+	}
+	else
+	{
+		// The converted file becomes the data's text. Cells are parsed in place and the entries point straight
+		// at them, so nothing is copied
+		NewData = FBYGLocaleData( MoveTemp( File.Wide ) );
+		NewData.Reserve( BYGCSVReading::CountLines( *NewData.Text, NewData.Text.Len() ), 0 );
+		FBYGCSVParser Parser( NewData.Text );
+		bParsed = BYGCSVReading::ParseLocaleData( Parser, Filename, *Settings, NewData );
+	}
+	if ( !bParsed )
+		return false;
+
+	BYG_INC_COUNTER( RowsParsed, NewData.Num() );
+	NewData.BuildIndex();
+	Data = MoveTemp( NewData );
 
 	return true;
 }
 
-bool UBYGLocalization::GetLocalizationStats( const FString& Filename, BYGLocStats& StatusCounts ) const
+bool UBYGLocalization::GetLocalizationStats( const FString& Filename, BYGLocStats& StatusCounts, const FThreadSafeBool* bCancelled ) const
 {
-	QUICK_SCOPE_CYCLE_COUNTER( STAT_BYGLocalization_GetLocalizationStats );
-
-	FString CSVData;
-	if ( FFileHelper::LoadFileToString( CSVData, *Filename ) )
-	{
-		StatusCounts.Empty();
-
-		StatusCounts.Add( EBYGLocEntryStatus::None, 0 );
-		StatusCounts.Add( EBYGLocEntryStatus::New, 0 );
-		StatusCounts.Add( EBYGLocEntryStatus::Modified, 0 );
-		StatusCounts.Add( EBYGLocEntryStatus::Deprecated, 0 );
-
-		const FCsvParser Parser( CSVData );
-		const FCsvParser::FRows& Rows = Parser.GetRows();
+	const FBYGStatusMatcher StatusMatcher( *SettingsProvider->GetSettings() );
+	return GetLocalizationStats( Filename, StatusMatcher, StatusCounts, bCancelled );
+}
 
-		const UBYGLocalizationSettings* Settings = SettingsProvider->GetSettings();
+bool UBYGLocalization::GetLocalizationStats( const FString& Filename, const FBYGStatusMatcher& StatusMatcher, BYGLocStats& StatusCounts, const FThreadSafeBool* bCancelled, uint64* OutHash )
+{
+	BYG_SCOPE_CYCLE_COUNTER( GetLocalizationStats );
+	BYG_LLM_SCOPE();
 
-		// Note that we skip the header
-		for ( int32 i = 1; i < Rows.Num(); ++i )
-		{
-			const TArray<const TCHAR*>& Row = Rows[ i ];
-			if ( Row.Num() >= 5 )
-			{
-				const FString Status( Row[ 4 ] );
-				if ( Status.StartsWith( Settings->DeprecatedStatus ) )
-				{
-					StatusCounts[ EBYGLocEntryStatus::Deprecated ] += 1;
-				}
-				else if ( Status.StartsWith( Settings->ModifiedStatusLeft ) )
-				{
-					StatusCounts[ EBYGLocEntryStatus::Modified ] += 1;
-				}
-				else if ( Status.StartsWith( Settings->NewStatus ) )
-				{
-					StatusCounts[ EBYGLocEntryStatus::New ] += 1;
-				}
-				else
-				{
-					StatusCounts[ EBYGLocEntryStatus::None ] += 1;
-				}
-			}
-		}
-	}
-	else
+	FBYGFileText File;
+	if ( !File.Load( *Filename, 0, OutHash ) )
 	{
 		UE_LOG( LogBYGLocalization, Error, TEXT( "Failed to load file '%s'" ), *Filename );
 		return false;
 	}
 
-	return true;
+	StatusCounts = BYGLocStats();
+
+	// UTF-8 files are scanned as bytes and never converted
+	if ( File.IsUTF8() )
+	{
+		FBYGUTF8CSVParser Parser( File.GetUTF8(), File.GetUTF8Len() );
+		return BYGCSVReading::CountStatuses( Parser, StatusMatcher, StatusCounts, bCancelled );
+	}
+
+	FBYGCSVParser Parser( File.Wide );
+	return BYGCSVReading::CountStatuses( Parser, StatusMatcher, StatusCounts, bCancelled );
 }
 
 FString UBYGLocalization::LazyWrap( const FString& InStr, bool bForceWrap )
@@ -416,7 +1069,7 @@ FString UBYGLocalization::ReplaceCharWithEscapedChar( const FString& Str )
 {
 	if ( Str.Len() > 0 )
 	{
-		QUICK_SCOPE_CYCLE_COUNTER( STAT_BYGLocalization_ReplaceCharWithEscapedChar );
+		BYG_SCOPE_CYCLE_COUNTER( ReplaceCharWithEscapedChar );
 
 		FString Result( *Str );
 		for ( uint32 ChIdx = 0; ChIdx < 1; ChIdx++ )
@@ -433,75 +1086,384 @@ FString UBYGLocalization::ReplaceCharWithEscapedChar( const FString& Str )
 
 // This is kind of unweidly with all the parameters but it makes testing way easier and it's an internal function
 // so what the hell.
-bool UBYGLocalization::WriteCSV( const TArray<FBYGLocalizationEntry>& Entries, const FString& Filename )
+namespace BYGCSVWriter
+{
+	// Same output as LazyWrap( ReplaceCharWithEscapedChar( Field ), bForceWrap ), or just the escaping when bAllowWrap
+	// is false, but appended straight into Out. Fields without quotes are copied in one go
+	void AppendField( FString& Out, const TCHAR* Field, int32 Len, bool bAllowWrap, bool bForceWrap )
+	{
+		bool bHasQuote = false;
+		bool bNeedsWrap = bForceWrap;
+		for ( int32 i = 0; i < Len; ++i )
+		{
+			const TCHAR Ch = Field[ i ];
+			if ( Ch == TEXT( '"' ) )
+			{
+				bHasQuote = true;
+				bNeedsWrap = true;
+				break;
+			}
+			bNeedsWrap |= Ch == TEXT( ',' ) || Ch == TEXT( '\r' ) || Ch == TEXT( '\n' );
+		}
+
+		const bool bWrap = bAllowWrap && bNeedsWrap && Len > 0;
+		if ( bWrap )
+		{
+			Out.AppendChar( TEXT( '"' ) );
+		}
+		if ( bHasQuote )
+		{
+			// RFC 4180 specifies that double quotes are escaped as ""
+			for ( int32 i = 0; i < Len; ++i )
+			{
+				if ( Field[ i ] == TEXT( '"' ) )
+				{
+					Out.AppendChar( TEXT( '"' ) );
+				}
+				Out.AppendChar( Field[ i ] );
+			}
+		}
+		else
+		{
+			Out.AppendChars( Field, Len );
+		}
+		if ( bWrap )
+		{
+			Out.AppendChar( TEXT( '"' ) );
+		}
+	}
+
+	void AppendField( FString& Out, const FStringView& Field, bool bAllowWrap, bool bForceWrap )
+	{
+		AppendField( Out, Field.GetData(), Field.Len(), bAllowWrap, bForceWrap );
+	}
+}
+
+bool UBYGLocalization::WriteCSV( const FBYGLocaleData& Data, const FString& Filename, bool* bOutWritten, uint64* OutHash, const uint64* ExistingHash )
 {
-	QUICK_SCOPE_CYCLE_COUNTER( STAT_BYGLocalization_WriteCSV );
+	BYG_SCOPE_CYCLE_COUNTER( WriteCSV );
+	BYG_LLM_SCOPE();
 
-	uint32 WriteFlags = 0;
-	WriteFlags |= FILEWRITE_EvenIfReadOnly;
-	FArchive* CSVFileWriter = IFileManager::Get().CreateFileWriter( *Filename, WriteFlags );
-	if ( !CSVFileWriter )
+	if ( bOutWritten )
 	{
-		UE_LOG( LogBYGLocalization, Error, TEXT( "Unable to open csv file \"%s\"." ), *Filename );
-		return false;
+		*bOutWritten = false;
 	}
 
 	const UBYGLocalizationSettings* Settings = SettingsProvider->GetSettings();
 
-	CSVFileWriter->Logf( TEXT( "Key,SourceString,Comment,Primary,Status" ) );
-
 	const bool bQuote = Settings->QuotingPolicy == EBYGQuotingPolicy::ForceQuoted;
 
-	for ( const FBYGLocalizationEntry& Entry : Entries )
+	// Size the buffer up-front so it's only allocated once: every field, plus quotes and delimiters
+	const int32 LineTerminatorLen = FCString::Strlen( LINE_TERMINATOR );
+	// Old primaries are already counted in the text
+	int32 EstimatedLen = 64 + Data.GetNumChars() + Data.Num() * ( 12 + LineTerminatorLen );
+	for ( int32 i = 0; i < Data.Num(); ++i )
+	{
+		const EBYGLocEntryStatus Status = Data.GetStatus( i );
+		if ( Status == EBYGLocEntryStatus::Modified )
+		{
+			EstimatedLen += Settings->ModifiedStatusLeft.Len() + Settings->ModifiedStatusRight.Len();
+		}
+		else if ( Status != EBYGLocEntryStatus::None )
+		{
+			EstimatedLen += FMath::Max( Settings->NewStatus.Len(), Settings->DeprecatedStatus.Len() );
+		}
+	}
+	EstimatedLen += EstimatedLen / 16;
+
+	FString Buffer;
+	Buffer.Reserve( EstimatedLen );
+
+	Buffer.Append( TEXT( "Key,SourceString,Comment,Primary,Status" ) );
+	Buffer.Append( LINE_TERMINATOR );
+
+	FString ModifiedStatus;
+	for ( int32 i = 0; i < Data.Num(); ++i )
 	{
-		if ( Entry.Status == EBYGLocEntryStatus::Deprecated && !Settings->bPreserveDeprecatedLines )
+		const EBYGLocEntryStatus Status = Data.GetStatus( i );
+		if ( Status == EBYGLocEntryStatus::Deprecated && !Settings->bPreserveDeprecatedLines )
 			continue;
 
-		// RFC 4180 specifies that double quotes are escaped as ""
-		const FString ExportedKey = ReplaceCharWithEscapedChar( Entry.Key );
-		const FString ExportedTranslation = ReplaceCharWithEscapedChar( Entry.Translation );
-		const FString ExportedComment = ReplaceCharWithEscapedChar( Entry.Comment );
-		const FString ExportedPrimary = ReplaceCharWithEscapedChar( Entry.Primary );
+		// The key is escaped but never wrapped
+		BYGCSVWriter::AppendField( Buffer, Data.GetKey( i ), false, false );
+		Buffer.AppendChar( TEXT( ',' ) );
+		BYGCSVWriter::AppendField( Buffer, Data.GetTranslation( i ), true, bQuote );
+		Buffer.AppendChar( TEXT( ',' ) );
+		BYGCSVWriter::AppendField( Buffer, Data.GetComment( i ), true, bQuote );
+		Buffer.AppendChar( TEXT( ',' ) );
+		BYGCSVWriter::AppendField( Buffer, Data.GetPrimary( i ), true, bQuote );
+		Buffer.AppendChar( TEXT( ',' ) );
+
+		if ( Status == EBYGLocEntryStatus::Deprecated )
+		{
+			BYGCSVWriter::AppendField( Buffer, Settings->DeprecatedStatus, true, bQuote );
+		}
+		else if ( Status == EBYGLocEntryStatus::Modified )
+		{
+			// Reused between rows so it only allocates when it has to grow
+			const FStringView OldPrimary = Data.GetOldPrimary( i );
+			ModifiedStatus.Reset();
+			ModifiedStatus.Append( Settings->ModifiedStatusLeft );
+			ModifiedStatus.AppendChars( OldPrimary.GetData(), OldPrimary.Len() );
+			ModifiedStatus.Append( Settings->ModifiedStatusRight );
+			BYGCSVWriter::AppendField( Buffer, ModifiedStatus, true, bQuote );
+		}
+		else if ( Status == EBYGLocEntryStatus::New )
+		{
+			BYGCSVWriter::AppendField( Buffer, Settings->NewStatus, true, bQuote );
+		}
+		Buffer.Append( LINE_TERMINATOR );
+	}
+
+	// Encode the same way FFileHelper::SaveStringToFile does, but keep the bytes so we can compare them.
+	// UTF-8 is hashed and written straight from the converter's buffer, only UTF-16 is copied to put the BOM in front
+	const bool bUTF16 = Settings->FileEncoding == EBYGFileEncoding::UTF16;
+	const FTCHARToUTF8 UTF8Converted( bUTF16 ? TEXT( "" ) : *Buffer, bUTF16 ? 0 : Buffer.Len() );
+	TArray<uint8> UTF16Bytes;
+	TArrayView<const uint8> Bytes;
+	if ( bUTF16 )
+	{
+		const auto Converted = StringCast<UCS2CHAR>( *Buffer, Buffer.Len() );
+		const UTF16CHAR BOM = UNICODE_BOM;
+		UTF16Bytes.Reserve( sizeof( BOM ) + Converted.Length() * sizeof( UCS2CHAR ) );
+		UTF16Bytes.Append( reinterpret_cast<const uint8*>( &BOM ), sizeof( BOM ) );
+		UTF16Bytes.Append( reinterpret_cast<const uint8*>( Converted.Get() ), Converted.Length() * sizeof( UCS2CHAR ) );
+		Bytes = UTF16Bytes;
+	}
+	else
+	{
+		Bytes = TArrayView<const uint8>( reinterpret_cast<const uint8*>( UTF8Converted.Get() ), UTF8Converted.Length() );
+	}
+	const int64 BufferBytes = Buffer.GetAllocatedSize() + Bytes.Num();
+	UpdateMemory.Add( BufferBytes );
+	ON_SCOPE_EXIT
+	{
+		UpdateMemory.Remove( BufferBytes );
+	};
+
+	const uint64 Hash = CityHash64( reinterpret_cast<const char*>( Bytes.GetData() ), Bytes.Num() );
+	if ( OutHash )
+	{
+		*OutHash = Hash;
+	}
+
+	// Leave files alone if they already have exactly this content, so their timestamps and source control status don't change
+	if ( ExistingHash && *ExistingHash == Hash )
+		return true;
+
+	if ( !ReplaceFile( Filename, Bytes, Settings->bCreateBackup ) )
+		return false;
+	BYG_INC_BYTES_COUNTER( BytesWritten, Bytes.Num() );
+
+	if ( bOutWritten )
+	{
+		*bOutWritten = true;
+	}
+	return true;
+}
+
+// Renames From over To in one step. IFileManager::Move deletes To first when replacing, which leaves a moment
+// where there is no file at all
+static bool RenameReplacing( const FString& To, const FString& From )
+{
+#if PLATFORM_WINDOWS
+	// MoveFileW won't replace an existing file, MoveFileExW can
+	FString FullTo = FPaths::ConvertRelativePathToFull( To );
+	FString FullFrom = FPaths::ConvertRelativePathToFull( From );
+	FPaths::MakePlatformFilename( FullTo );
+	FPaths::MakePlatformFilename( FullFrom );
+	return ::MoveFileExW( *FullFrom, *FullTo, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) != 0;
+#else
+	// rename() replaces the destination atomically
+	return FPlatformFileManager::Get().GetPlatformFile().MoveFile( *To, *From );
+#endif
+}
+
+// Gives the file at From a second name. Returns false where hard links aren't supported, e.g. FAT drives
+static bool HardLink( const FString& To, const FString& From )
+{
+	FString FullTo = FPaths::ConvertRelativePathToFull( To );
+	FString FullFrom = FPaths::ConvertRelativePathToFull( From );
+#if PLATFORM_WINDOWS
+	FPaths::MakePlatformFilename( FullTo );
+	FPaths::MakePlatformFilename( FullFrom );
+	return ::CreateHardLinkW( *FullTo, *FullFrom, nullptr ) != 0;
+#elif PLATFORM_UNIX || PLATFORM_MAC
+	return ::link( TCHAR_TO_UTF8( *FullFrom ), TCHAR_TO_UTF8( *FullTo ) ) == 0;
+#else
+	return false;
+#endif
+}
+
+bool UBYGLocalization::ReplaceFile( const FString& Filename, TArrayView<const uint8> Bytes, bool bCreateBackup )
+{
+	IFileManager& FileManager = IFileManager::Get();
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
 
-		FString ExportedStatus = "";
-		if ( Entry.Status == EBYGLocEntryStatus::Deprecated )
+	// One write for the whole file, into a temp file next to it so an interrupted update never leaves a truncated file.
+	// It's flushed before the rename, so a crash can't leave the renamed file empty either
+	const FString TempFilename = Filename + TEXT( ".tmp" );
+	FileManager.Delete( *TempFilename, false, true, true );
+	{
+		TUniquePtr<IFileHandle> Handle( PlatformFile.OpenWrite( *TempFilename ) );
+		const bool bWritten = Handle && Handle->Write( Bytes.GetData(), Bytes.Num() ) && Handle->Flush( true );
+		Handle.Reset();
+		if ( !bWritten )
 		{
-			ExportedStatus = Settings->DeprecatedStatus;
+			UE_LOG( LogBYGLocalization, Error, TEXT( "Unable to write csv file \"%s\"." ), *TempFilename );
+			FileManager.Delete( *TempFilename, false, true, true );
+			return false;
 		}
-		else if ( Entry.Status == EBYGLocEntryStatus::Modified )
+	}
+
+	const bool bExists = FileManager.FileExists( *Filename );
+	const FString BackupFilename = Filename + TEXT( ".bak" );
+	if ( bCreateBackup && bExists )
+	{
+		// Linked rather than renamed, so Filename is never missing, and rather than copied, so backing up doesn't write
+		// the file a second time. The rename below gives Filename the new contents and leaves the link with the old ones
+		FileManager.Delete( *BackupFilename, false, true, true );
+		if ( !HardLink( BackupFilename, Filename ) && FileManager.Copy( *BackupFilename, *Filename, true, true ) != COPY_OK )
 		{
-			ExportedStatus = FString::Printf( TEXT( "%s%s%s" ), *Settings->ModifiedStatusLeft, *Entry.OldPrimary, *Settings->ModifiedStatusRight );
+			UE_LOG( LogBYGLocalization, Error, TEXT( "Unable to back up csv file \"%s\" to \"%s\"." ), *Filename, *BackupFilename );
+			FileManager.Delete( *TempFilename, false, true, true );
+			return false;
 		}
-		else if ( Entry.Status == EBYGLocEntryStatus::New )
+	}
+
+	// Same as writing with FILEWRITE_EvenIfReadOnly, whether read-only files are updated at all is decided before we get here
+	if ( bExists && PlatformFile.IsReadOnly( *Filename ) )
+	{
+		PlatformFile.SetReadOnly( *Filename, false );
+	}
+
+	if ( !RenameReplacing( Filename, TempFilename ) )
+	{
+		UE_LOG( LogBYGLocalization, Error, TEXT( "Unable to move \"%s\" over csv file \"%s\"." ), *TempFilename, *Filename );
+		FileManager.Delete( *TempFilename, false, true, true );
+		// The rename either happens or it doesn't, but put the old file back if it somehow went missing
+		if ( bCreateBackup && bExists && !FileManager.FileExists( *Filename ) )
 		{
-			ExportedStatus = Settings->NewStatus;
+			FileManager.Copy( *Filename, *BackupFilename, true, true );
 		}
-		ExportedStatus = ReplaceCharWithEscapedChar( ExportedStatus );
+		return false;
+	}
+
+	return true;
+}
+
+
+namespace BYGUpdateReport
+{
+	// Indexed by EBYGLocEntryStatus, the same names the stats window uses
+	static const TCHAR* StatusNames[ BYGLocStats::NumStatuses ] = { TEXT( "None" ), TEXT( "New" ), TEXT( "Modified" ), TEXT( "Deprecated" ) };
+	// None is never a change
+	static const int32 FirstChangedStatus = static_cast<int32>( EBYGLocEntryStatus::New );
+}
+
+FString FBYGUpdateReport::GetDefaultPath( EBYGUpdateReportFormat Format )
+{
+	return FPaths::Combine( FPaths::ProjectSavedDir(), TEXT( "BYGLocalization" ),
+		Format == EBYGUpdateReportFormat::CSV ? TEXT( "UpdateReport.csv" ) : TEXT( "UpdateReport.json" ) );
+}
 
-		CSVFileWriter->Logf( TEXT( "%s,%s,%s,%s,%s" ),
-			*ExportedKey,
-			*LazyWrap( ExportedTranslation, bQuote),
-			*LazyWrap( ExportedComment, bQuote ),
-			*LazyWrap( ExportedPrimary, bQuote ),
-			*LazyWrap( ExportedStatus, bQuote ) );
+bool FBYGUpdateReport::Save( const FString& Path, EBYGUpdateReportFormat Format ) const
+{
+	switch ( Format )
+	{
+	case EBYGUpdateReportFormat::JSON:
+		return SaveJson( Path );
+	case EBYGUpdateReportFormat::CSV:
+		return SaveCSV( Path );
+	default:
+		return false;
 	}
+}
 
-	CSVFileWriter->Close();
+bool FBYGUpdateReport::SaveJson( const FString& Path ) const
+{
+	TArray<TSharedPtr<FJsonValue>> JsonFiles;
+	JsonFiles.Reserve( Files.Num() );
+	for ( const FBYGUpdateFileResult& File : Files )
+	{
+		TSharedRef<FJsonObject> JsonFile = MakeShared<FJsonObject>();
+		JsonFile->SetStringField( TEXT( "Locale" ), File.Culture );
+		JsonFile->SetStringField( TEXT( "Path" ), File.Path );
+		JsonFile->SetBoolField( TEXT( "Written" ), File.bWritten );
+
+		TSharedRef<FJsonObject> Counts = MakeShared<FJsonObject>();
+		TSharedRef<FJsonObject> Keys = MakeShared<FJsonObject>();
+		for ( int32 Status = BYGUpdateReport::FirstChangedStatus; Status < BYGLocStats::NumStatuses; ++Status )
+		{
+			Counts->SetNumberField( BYGUpdateReport::StatusNames[ Status ], File.ChangedKeys[ Status ].Num() );
+
+			TArray<TSharedPtr<FJsonValue>> JsonKeys;
+			JsonKeys.Reserve( File.ChangedKeys[ Status ].Num() );
+			for ( const FString& Key : File.ChangedKeys[ Status ] )
+			{
+				JsonKeys.Add( MakeShared<FJsonValueString>( Key ) );
+			}
+			Keys->SetArrayField( BYGUpdateReport::StatusNames[ Status ], JsonKeys );
+		}
+		JsonFile->SetObjectField( TEXT( "Counts" ), Counts );
+		JsonFile->SetObjectField( TEXT( "Keys" ), Keys );
 
-	return !CSVFileWriter->IsError();
+		TArray<TSharedPtr<FJsonValue>> JsonWarnings;
+		for ( const FString& Warning : File.Warnings )
+		{
+			JsonWarnings.Add( MakeShared<FJsonValueString>( Warning ) );
+		}
+		JsonFile->SetArrayField( TEXT( "Warnings" ), JsonWarnings );
+
+		JsonFiles.Add( MakeShared<FJsonValueObject>( JsonFile ) );
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetArrayField( TEXT( "Files" ), JsonFiles );
+
+	FString JsonString;
+	if ( !FJsonSerializer::Serialize( Root, TJsonWriterFactory<>::Create( &JsonString ) ) )
+		return false;
+
+	return FFileHelper::SaveStringToFile( JsonString, *Path );
+}
+
+bool FBYGUpdateReport::SaveCSV( const FString& Path ) const
+{
+	FString Buffer;
+	Buffer.Append( TEXT( "Locale,Path,Status,Key" ) );
+	Buffer.Append( LINE_TERMINATOR );
+	for ( const FBYGUpdateFileResult& File : Files )
+	{
+		for ( int32 Status = BYGUpdateReport::FirstChangedStatus; Status < BYGLocStats::NumStatuses; ++Status )
+		{
+			for ( const FString& Key : File.ChangedKeys[ Status ] )
+			{
+				BYGCSVWriter::AppendField( Buffer, File.Culture, true, false );
+				Buffer.AppendChar( TEXT( ',' ) );
+				BYGCSVWriter::AppendField( Buffer, File.Path, true, false );
+				Buffer.AppendChar( TEXT( ',' ) );
+				Buffer.Append( BYGUpdateReport::StatusNames[ Status ] );
+				Buffer.AppendChar( TEXT( ',' ) );
+				BYGCSVWriter::AppendField( Buffer, Key, true, false );
+				Buffer.Append( LINE_TERMINATOR );
+			}
+		}
+	}
+
+	return FFileHelper::SaveStringToFile( Buffer, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM );
 }
 
 
 TArray<FBYGLocaleInfo> UBYGLocalization::GetAvailableLocalizations() const
 {
-	TArray<FBYGLocaleInfo> Localizations;
+	const FFileListRef Files = GetLocalizationFilesSnapshot();
 
-	const TArray<FString> Files = GetAllLocalizationFiles();
-	for ( const FString& FileWithPath : Files )
+	TArray<FBYGLocaleInfo> Localizations;
+	Localizations.Reserve( Files->Num() );
+	for ( const FString& FileWithPath : *Files )
 	{
-		FBYGLocaleInfo Basic = GetCultureFromFilename( FileWithPath );
-		const FString FullPath = FPaths::Combine( FPaths::ProjectContentDir(), FileWithPath );
-		Localizations.Add( Basic );
+		Localizations.Add( GetCultureFromFilename( FileWithPath ) );
 	}
 
 	return Localizations;
@@ -520,21 +1482,12 @@ bool UBYGLocalization::GetLocaleFromPreferences( FBYGLocaleInfo& FoundLocale ) c
 		FInternationalization::Get().GetDefaultLocale()
 	};
 
-	for ( const FCultureRef Culture : ToTest )
+	for ( const FCultureRef& Culture : ToTest )
 	{
-		for ( const FBYGLocaleInfo Info : AllLocalizations )
+		// Special cases like Chinese are in the culture cache's override table
+		const FString LocaleName = FBYGCultureCache::Get().GetLocaleCodeForCulture( Culture );
+		for ( const FBYGLocaleInfo& Info : AllLocalizations )
 		{
-			// Special cases for Chinese
-			FString LocaleName = Culture.Get().GetTwoLetterISOLanguageName();
-			if ( Culture.Get().GetName() == "zh-CN" )
-			{
-				LocaleName = "cn_HANS";
-			}
-			else if ( Culture.Get().GetName() == "zh-TW" )
-			{
-				LocaleName = "cn_HANS";
-			}
-
 			if ( LocaleName == Info.LocaleCode )
 			{
 				FoundLocale = Info;
@@ -568,20 +1521,9 @@ FBYGLocaleInfo UBYGLocalization::GetCultureFromFilename( const FString& FileWith
 	const UBYGLocalizationSettings* Settings = SettingsProvider->GetSettings();
 	const FString LocaleCode = RemovePrefixSuffix( FileWithPath );
 
-	FText LocalizedName;
-	const FCulturePtr FoundCulture = FInternationalization::Get().GetCulture( LocaleCode );
-	if ( FoundCulture.IsValid() )
-	{
-		LocalizedName = FText::FromString( FoundCulture->GetNativeLanguage() );
-	}
-	else
-	{
-		// Couldn't find localized name, just show raw filename
-		LocalizedName = FText::FromString( LocaleCode );
-	}
 	FBYGLocaleInfo Info {
 		LocaleCode,
-		LocalizedName,
+		FBYGCultureCache::Get().Find( LocaleCode ).NativeName,
 		FileWithPath
 	};
 
@@ -1,5 +1,85 @@
 #include "BYGLocalizationCoreMinimal.h"
 
+#include "Hash/CityHash.h"
+#include "Misc/FileHelper.h"
+
 DEFINE_LOG_CATEGORY( LogBYGLocalization );
 
+CSV_DEFINE_CATEGORY_MODULE( BYGLOCALIZATION_API, BYGLocalization, true );
+
+#if BYG_WITH_TRACE_CHANNEL
+UE_TRACE_CHANNEL_DEFINE( BYGLocalizationChannel );
+#endif
+
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 27
+LLM_DEFINE_TAG( BYGLocalization );
+#endif
+
+DEFINE_STAT( STAT_BYGLocalization_DiscoverLocalizationFiles );
+DEFINE_STAT( STAT_BYGLocalization_ResolveCulture );
+
+DEFINE_STAT( STAT_BYGLocalization_GetLocalizationData );
+DEFINE_STAT( STAT_BYGLocalization_BuildIndex );
+DEFINE_STAT( STAT_BYGLocalization_GetLocalizationStats );
+
+DEFINE_STAT( STAT_BYGLocalization_UpdateTranslations );
+DEFINE_STAT( STAT_BYGLocalization_UpdateTranslationFile );
+DEFINE_STAT( STAT_BYGLocalization_ComputePrimaryDelta );
+DEFINE_STAT( STAT_BYGLocalization_ApplyPrimaryDelta );
+
+DEFINE_STAT( STAT_BYGLocalization_WriteCSV );
+DEFINE_STAT( STAT_BYGLocalization_ReplaceCharWithEscapedChar );
+DEFINE_STAT( STAT_BYGLocalization_WriteCompiled );
+
+DEFINE_STAT( STAT_BYGLocalization_BuildStringTable );
+DEFINE_STAT( STAT_BYGLocalization_LoadCompiled );
+DEFINE_STAT( STAT_BYGLocalization_RegisterStringTable );
+DEFINE_STAT( STAT_BYGLocalization_PatchStringTables );
+DEFINE_STAT( STAT_BYGLocalization_ComputePatch );
+
+DEFINE_STAT( STAT_BYGLocalization_FindGameText );
+DEFINE_STAT( STAT_BYGLocalization_FindGameTextBatch );
+DEFINE_STAT( STAT_BYGLocalization_RefreshGameTextCache );
+
+DEFINE_STAT( STAT_BYGLocalization_BytesRead );
+DEFINE_STAT( STAT_BYGLocalization_BytesWritten );
+DEFINE_STAT( STAT_BYGLocalization_RowsParsed );
+
+DEFINE_STAT( STAT_BYGLocalization_Lookups );
+DEFINE_STAT( STAT_BYGLocalization_LookupMisses );
+DEFINE_STAT( STAT_BYGLocalization_FallbackHits );
+
+bool FBYGFileText::Load( const TCHAR* Filename, uint32 ReadFlags, uint64* OutHash )
+{
+	Wide.Empty();
+	UTF8Start = 0;
+	bIsUTF8 = false;
+
+	if ( !FFileHelper::LoadFileToArray( Bytes, Filename, ReadFlags ) )
+		return false;
+
+	BYG_INC_BYTES_COUNTER( BytesRead, Bytes.Num() );
+
+	// Before anything is parsed in place
+	if ( OutHash )
+	{
+		*OutHash = CityHash64( reinterpret_cast<const char*>( Bytes.GetData() ), Bytes.Num() );
+	}
+
+	// Anything without a UTF-16 byte order mark is UTF-8, same as FFileHelper::BufferToString
+	const bool bIsUTF16 = Bytes.Num() >= 2
+		&& ( ( Bytes[ 0 ] == 0xFF && Bytes[ 1 ] == 0xFE ) || ( Bytes[ 0 ] == 0xFE && Bytes[ 1 ] == 0xFF ) );
+	if ( bIsUTF16 )
+	{
+		FFileHelper::BufferToString( Wide, Bytes.GetData(), Bytes.Num() );
+		Bytes.Empty();
+		return true;
+	}
 
+	bIsUTF8 = true;
+	if ( Bytes.Num() >= 3 && Bytes[ 0 ] == 0xEF && Bytes[ 1 ] == 0xBB && Bytes[ 2 ] == 0xBF )
+	{
+		UTF8Start = 3;
+	}
+	return true;
+}
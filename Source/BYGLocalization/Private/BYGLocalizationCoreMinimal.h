@@ -1,7 +1,115 @@
 #pragma once
 #include "Logging/LogMacros.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "Stats/Stats.h"
 
 // Maybe this doesn't need to be extern?
 DECLARE_LOG_CATEGORY_EXTERN( LogBYGLocalization, Log, All );
 
+// Everything is in "stat BYGLocalization", the BYGLocalization CSV profiler category and, from 4.26, the
+// BYGLocalization Insights trace channel (-trace=cpu,BYGLocalization)
+DECLARE_STATS_GROUP( TEXT( "BYGLocalization" ), STATGROUP_BYGLocalization, STATCAT_Advanced );
 
+CSV_DECLARE_CATEGORY_MODULE_EXTERN( BYGLOCALIZATION_API, BYGLocalization );
+
+#define BYG_WITH_TRACE_CHANNEL ( ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 26 )
+#if BYG_WITH_TRACE_CHANNEL
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+UE_TRACE_CHANNEL_EXTERN( BYGLocalizationChannel, BYGLOCALIZATION_API );
+#define BYG_TRACE_SCOPE( Name ) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL( Name, BYGLocalizationChannel )
+#else
+#define BYG_TRACE_SCOPE( Name )
+#endif
+
+// Times the rest of the scope with STAT_BYGLocalization_<Name>, which must be declared below
+#define BYG_SCOPE_CYCLE_COUNTER( Name ) \
+	SCOPE_CYCLE_COUNTER( STAT_BYGLocalization_##Name ); \
+	CSV_SCOPED_TIMING_STAT( BYGLocalization, Name ); \
+	BYG_TRACE_SCOPE( BYGLocalization_##Name )
+
+// Adds to STAT_BYGLocalization_<Name> and the CSV stat with the same name. Safe to use from any thread
+#define BYG_INC_COUNTER( Name, Amount ) \
+	INC_DWORD_STAT_BY( STAT_BYGLocalization_##Name, Amount ); \
+	CSV_CUSTOM_STAT( BYGLocalization, Name, static_cast<int32>( Amount ), ECsvCustomStatOp::Accumulate )
+
+// As BYG_INC_COUNTER, for the 64-bit byte totals. The CSV stat is per frame, so int32 is plenty there
+#define BYG_INC_BYTES_COUNTER( Name, Amount ) \
+	INC_QWORD_STAT_BY( STAT_BYGLocalization_##Name, static_cast<int64>( Amount ) ); \
+	CSV_CUSTOM_STAT( BYGLocalization, Name, static_cast<int32>( Amount ), ECsvCustomStatOp::Accumulate )
+
+// Discovery
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Discover files" ), STAT_BYGLocalization_DiscoverLocalizationFiles, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Resolve culture" ), STAT_BYGLocalization_ResolveCulture, STATGROUP_BYGLocalization, );
+
+// Parsing
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Parse file" ), STAT_BYGLocalization_GetLocalizationData, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Build key index" ), STAT_BYGLocalization_BuildIndex, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Get stats" ), STAT_BYGLocalization_GetLocalizationStats, STATGROUP_BYGLocalization, );
+
+// Merging
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Update translations" ), STAT_BYGLocalization_UpdateTranslations, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Update file" ), STAT_BYGLocalization_UpdateTranslationFile, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Compute primary delta" ), STAT_BYGLocalization_ComputePrimaryDelta, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Apply primary delta" ), STAT_BYGLocalization_ApplyPrimaryDelta, STATGROUP_BYGLocalization, );
+
+// Writing
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Write CSV" ), STAT_BYGLocalization_WriteCSV, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Escape characters" ), STAT_BYGLocalization_ReplaceCharWithEscapedChar, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Write compiled" ), STAT_BYGLocalization_WriteCompiled, STATGROUP_BYGLocalization, );
+
+// String tables
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Build string table" ), STAT_BYGLocalization_BuildStringTable, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Load compiled" ), STAT_BYGLocalization_LoadCompiled, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Register string table" ), STAT_BYGLocalization_RegisterStringTable, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Patch string tables" ), STAT_BYGLocalization_PatchStringTables, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Compute patch" ), STAT_BYGLocalization_ComputePatch, STATGROUP_BYGLocalization, );
+
+// Lookup
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Find game text" ), STAT_BYGLocalization_FindGameText, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Find game text batch" ), STAT_BYGLocalization_FindGameTextBatch, STATGROUP_BYGLocalization, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Refresh game text cache" ), STAT_BYGLocalization_RefreshGameTextCache, STATGROUP_BYGLocalization, );
+
+// Totals since startup. Bytes are 64-bit, a long editor session can read more than 4 GB
+DECLARE_QWORD_ACCUMULATOR_STAT_EXTERN( TEXT( "Bytes read" ), STAT_BYGLocalization_BytesRead, STATGROUP_BYGLocalization, );
+DECLARE_QWORD_ACCUMULATOR_STAT_EXTERN( TEXT( "Bytes written" ), STAT_BYGLocalization_BytesWritten, STATGROUP_BYGLocalization, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN( TEXT( "Rows parsed" ), STAT_BYGLocalization_RowsParsed, STATGROUP_BYGLocalization, );
+// Keys found in the primary language table because the current one doesn't have them, counted when first cached
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN( TEXT( "Fallback hits" ), STAT_BYGLocalization_FallbackHits, STATGROUP_BYGLocalization, );
+
+// Per frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN( TEXT( "Lookups" ), STAT_BYGLocalization_Lookups, STATGROUP_BYGLocalization, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN( TEXT( "Lookup misses" ), STAT_BYGLocalization_LookupMisses, STATGROUP_BYGLocalization, );
+
+// Tags allocations made by the plugin, see "stat LLM" or -llmcsv. Engines before 4.27 have no custom tags, so
+// there they count towards the engine's Localization tag
+#include "HAL/LowLevelMemTracker.h"
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 27
+LLM_DECLARE_TAG_API( BYGLocalization, BYGLOCALIZATION_API );
+#define BYG_LLM_SCOPE() LLM_SCOPE_BYTAG( BYGLocalization )
+#else
+#define BYG_LLM_SCOPE() LLM_SCOPE( ELLMTag::Localization )
+#endif
+
+// A whole file loaded for parsing. UTF-8 files, with or without a byte order mark, are kept as they are so they can
+// be parsed without converting the whole file. Files with a UTF-16 byte order mark are converted to Wide, the same
+// way FFileHelper::LoadFileToString does
+struct FBYGFileText
+{
+	// Counts the bytes read. OutHash is the hash of the file as it is on disk, same as FBYGUpdateManifest::HashFile
+	bool Load( const TCHAR* Filename, uint32 ReadFlags = 0, uint64* OutHash = nullptr );
+
+	bool IsUTF8() const { return bIsUTF8; }
+	// The text after the byte order mark. Writable so the parser can work in place
+	ANSICHAR* GetUTF8() { return reinterpret_cast<ANSICHAR*>( Bytes.GetData() ) + UTF8Start; }
+	int32 GetUTF8Len() const { return Bytes.Num() - UTF8Start; }
+
+	// Only used if the file isn't UTF-8
+	FString Wide;
+
+protected:
+	TArray<uint8> Bytes;
+	int32 UTF8Start = 0;
+	bool bIsUTF8 = false;
+};
@@ -1,15 +1,40 @@
 // Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
 
 #include "BYGLocalizationModule.h"
+#include "BYGLocalizationCoreMinimal.h"
 #include "BYGLocalizationSettings.h"
 #include "BYGLocalization.h"
+#include "BYGStringTableLoader.h"
 
-#include "Internationalization/StringTableRegistry.h"
+#include "HAL/IConsoleManager.h"
 #include "Misc/CommandLine.h"
 #include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+#if BYG_WITH_HOT_RELOAD
+#include "Containers/Ticker.h"
+#include "DirectoryWatcherModule.h"
+#include "IDirectoryWatcher.h"
+
+// FTicker is deprecated in UE5, its thread-safe replacement works the same way for us
+#if ENGINE_MAJOR_VERSION >= 5
+typedef FTSTicker FBYGCoreTicker;
+#else
+typedef FTicker FBYGCoreTicker;
+#endif
+#endif
 
 #define LOCTEXT_NAMESPACE "BYGLocalizationModule"
 
+static FAutoConsoleCommand BYGLocalizationMemoryCommand(
+	TEXT( "BYG.Localization.Memory" ),
+	TEXT( "Logs the memory used by each loaded localization string table and by the last translation update. Pass Update to run an update first." ),
+	FConsoleCommandWithArgsDelegate::CreateLambda( []( const TArray<FString>& Args )
+	{
+		const bool bRunUpdate = Args.ContainsByPredicate( []( const FString& Arg ) { return Arg.Equals( TEXT( "Update" ), ESearchCase::IgnoreCase ); } );
+		FBYGLocalizationModule::Get().LogMemoryReport( bRunUpdate );
+	} ) );
+
 void FBYGLocalizationModule::StartupModule()
 {
 	Loc = MakeShareable( new UBYGLocalization() );
@@ -41,6 +66,8 @@ void FBYGLocalizationModule::StartupModule()
 
 void FBYGLocalizationModule::ShutdownModule()
 {
+	StopWatchingFiles();
+
 	// Using this because GetDefault<UBYGLocalizationSettings>() is not valid inside ShutdownModule
 	UnloadLocalizations();
 
@@ -50,6 +77,7 @@ void FBYGLocalizationModule::ShutdownModule()
 void FBYGLocalizationModule::ReloadLocalizations()
 {
 	UnloadLocalizations();
+	Loc->InvalidateLocalizationFiles();
 
 	// TODO provider
 	const UBYGLocalizationSettings* Settings = Provider->GetSettings();
@@ -58,16 +86,29 @@ void FBYGLocalizationModule::ReloadLocalizations()
 	// For example it could be French if the player has chosen to use French
 	const FString Filename = Loc->GetFileWithPathFromLanguageCode( Settings->PrimaryLanguageCode );
 	StringTableIDs.Add( FName( *Settings->StringtableID ) );
-	FStringTableRegistry::Get().Internal_LocTableFromFile( StringTableIDs[ 0 ], Settings->StringtableNamespace, Filename, FPaths::ProjectContentDir() );
+	FBYGStringTableLoader::RegisterStringTable( StringTableIDs[ 0 ], Filename, Settings->StringtableNamespace, Settings->bUseCompiledLocalizations );
 
 	// We don't want to register this when we're in editor, because we don't want the 'en' language to be shown when selecting FText in Blueprints
 #if !WITH_EDITOR
 	// We always keep the localization for the Primary language in memory and use it as a fallback in case a string is not found in another language
 	{
 		StringTableIDs.Add( FName( *Settings->PrimaryLanguageCode ) );
-		FStringTableRegistry::Get().Internal_LocTableFromFile( StringTableIDs[ 1 ], Settings->StringtableNamespace, Filename, FPaths::ProjectContentDir() );
+		FBYGStringTableLoader::RegisterStringTable( StringTableIDs[ 1 ], Filename, Settings->StringtableNamespace, Settings->bUseCompiledLocalizations );
 	}
 #endif
+
+	// The directories may have changed too
+	RestartWatchingFiles();
+}
+
+bool FBYGLocalizationModule::PreloadPreferredLocalization( FBYGLocaleInfo& OutLocale )
+{
+	if ( !Loc->GetLocaleFromPreferences( OutLocale ) )
+		return false;
+
+	const UBYGLocalizationSettings* Settings = Provider->GetSettings();
+	FBYGStringTableLoader::PreloadStringTable( OutLocale.FilePath, Settings->StringtableNamespace, Settings->bUseCompiledLocalizations );
+	return true;
 }
 
 void FBYGLocalizationModule::UnloadLocalizations()
@@ -75,11 +116,164 @@ void FBYGLocalizationModule::UnloadLocalizations()
 	// Using this because GetDefault<UBYGLocalizationSettings>() is not valid inside ShutdownModule
 	for ( const FName& ID : StringTableIDs )
 	{
-		FStringTableRegistry::Get().UnregisterStringTable( ID );
+		FBYGStringTableLoader::UnregisterStringTable( ID );
 	}
 	StringTableIDs.Empty();
 }
 
+void FBYGLocalizationModule::RestartWatchingFiles()
+{
+	StopWatchingFiles();
+	StartWatchingFiles();
+}
+
+void FBYGLocalizationModule::StartWatchingFiles()
+{
+#if BYG_WITH_HOT_RELOAD
+	const UBYGLocalizationSettings* Settings = Provider->GetSettings();
+	if ( !( GIsEditor ? Settings->bHotReloadInEditor : Settings->bHotReloadInDevelopmentBuilds ) )
+		return;
+
+	FDirectoryWatcherModule& DirectoryWatcherModule = FModuleManager::LoadModuleChecked<FDirectoryWatcherModule>( TEXT( "DirectoryWatcher" ) );
+	IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule.Get();
+	if ( !DirectoryWatcher )
+		return;
+
+	// Directory changes are needed so the list of localization files is rescanned when a folder of them is added
+	const uint32 WatchFlags = IDirectoryWatcher::WatchOptions::IncludeDirectoryChanges
+		| ( Settings->bIncludeSubdirectories ? 0 : IDirectoryWatcher::WatchOptions::IgnoreChangesInSubtree );
+	for ( const FString& Directory : Loc->GetLocalizationDirectories() )
+	{
+		if ( !FPaths::DirectoryExists( Directory ) )
+			continue;
+
+		FDelegateHandle Handle;
+		if ( DirectoryWatcher->RegisterDirectoryChangedCallback_Handle( Directory,
+			IDirectoryWatcher::FDirectoryChanged::CreateRaw( this, &FBYGLocalizationModule::OnDirectoryChanged ),
+			Handle,
+			WatchFlags ) )
+		{
+			WatchedDirectories.Emplace( Directory, Handle );
+		}
+	}
+
+	HotReloadTickerHandle = FBYGCoreTicker::GetCoreTicker().AddTicker( FTickerDelegate::CreateRaw( this, &FBYGLocalizationModule::TickHotReload ) );
+#endif
+}
+
+void FBYGLocalizationModule::StopWatchingFiles()
+{
+#if BYG_WITH_HOT_RELOAD
+	// May already be gone during shutdown
+	FDirectoryWatcherModule* DirectoryWatcherModule = FModuleManager::GetModulePtr<FDirectoryWatcherModule>( TEXT( "DirectoryWatcher" ) );
+	IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule ? DirectoryWatcherModule->Get() : nullptr;
+	if ( DirectoryWatcher )
+	{
+		for ( const TPair<FString, FDelegateHandle>& Watched : WatchedDirectories )
+		{
+			DirectoryWatcher->UnregisterDirectoryChangedCallback_Handle( Watched.Key, Watched.Value );
+		}
+	}
+	WatchedDirectories.Empty();
+
+	if ( HotReloadTickerHandle.IsValid() )
+	{
+		FBYGCoreTicker::GetCoreTicker().RemoveTicker( HotReloadTickerHandle );
+		HotReloadTickerHandle.Reset();
+	}
+	PendingHotReloadFiles.Empty();
+#endif
+}
+
+void FBYGLocalizationModule::OnDirectoryChanged( const TArray<FFileChangeData>& Changes )
+{
+#if BYG_WITH_HOT_RELOAD
+	bool bFilesAddedOrRemoved = false;
+	for ( const FFileChangeData& Change : Changes )
+	{
+		// Could be a localization file or a directory holding some, either way the file list needs a rescan
+		bFilesAddedOrRemoved |= Change.Action != FFileChangeData::FCA_Modified;
+
+		// Deleted files keep their tables. Updating a file writes .tmp and .bak files next to it, the extension
+		// check skips those
+		if ( Change.Action == FFileChangeData::FCA_Removed || !Loc->IsLocalizationFile( Change.Filename ) )
+			continue;
+
+		PendingHotReloadFiles.Add( FPaths::ConvertRelativePathToFull( Change.Filename ) );
+		LastFileChangeTime = FPlatformTime::Seconds();
+	}
+
+	if ( bFilesAddedOrRemoved )
+	{
+		Loc->InvalidateLocalizationFiles();
+	}
+#endif
+}
+
+bool FBYGLocalizationModule::TickHotReload( float DeltaTime )
+{
+#if BYG_WITH_HOT_RELOAD
+	// The editor ticks the directory watcher itself, games don't
+	if ( !GIsEditor )
+	{
+		FDirectoryWatcherModule& DirectoryWatcherModule = FModuleManager::GetModuleChecked<FDirectoryWatcherModule>( TEXT( "DirectoryWatcher" ) );
+		if ( IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule.Get() )
+		{
+			DirectoryWatcher->Tick( DeltaTime );
+		}
+	}
+
+	if ( PendingHotReloadFiles.Num() > 0 && FPlatformTime::Seconds() - LastFileChangeTime >= Provider->GetSettings()->HotReloadDelay )
+	{
+		for ( const FString& File : PendingHotReloadFiles )
+		{
+			UE_LOG( LogBYGLocalization, Log, TEXT( "Localization file '%s' changed, hot reloading" ), *File );
+			FBYGStringTableLoader::PatchStringTablesAsync( File );
+		}
+		PendingHotReloadFiles.Empty();
+	}
+#endif
+	return true;
+}
+
+void FBYGLocalizationModule::LogMemoryReport( bool bRunUpdate )
+{
+	static const double MB = 1024.0 * 1024.0;
+
+	if ( bRunUpdate )
+	{
+		Loc->UpdateTranslations();
+	}
+
+	TArray<FBYGStringTableLoader::FTableMemory> Tables;
+	FBYGStringTableLoader::GetTableMemory( Tables );
+	SIZE_T TotalBytes = 0;
+	for ( const FBYGStringTableLoader::FTableMemory& Table : Tables )
+	{
+		UE_LOG( LogBYGLocalization, Display, TEXT( "String table '%s' (%s, %d keys): keys %.2f MB, strings %.2f MB, index %.2f MB, total %.2f MB" ),
+			*Table.TableID.ToString(),
+			Table.Path.IsEmpty() ? TEXT( "unknown file" ) : *Loc->GetCultureFromFilename( Table.Path ).LocaleCode,
+			Table.NumKeys,
+			Table.KeyBytes / MB,
+			Table.StringBytes / MB,
+			Table.IndexBytes / MB,
+			Table.GetTotalBytes() / MB );
+		TotalBytes += Table.GetTotalBytes();
+	}
+	UE_LOG( LogBYGLocalization, Display, TEXT( "%d string tables, %.2f MB" ), Tables.Num(), TotalBytes / MB );
+
+	const FBYGUpdateMemoryReport& Update = Loc->GetLastUpdateMemory();
+	if ( Update.NumFiles > 0 )
+	{
+		UE_LOG( LogBYGLocalization, Display, TEXT( "Last translation update: %d files, peak %.2f MB, %.2f MB of it primary data" ),
+			Update.NumFiles, Update.PeakBytes / MB, Update.PrimaryBytes / MB );
+	}
+	else
+	{
+		UE_LOG( LogBYGLocalization, Display, TEXT( "No translation update has merged any files yet" ) );
+	}
+}
+
 void FBYGLocalizationModule::AddReferencedObjects( FReferenceCollector& Collector )
 {
 	//Collector.AddReferencedObject( Loc );
@@ -51,6 +51,7 @@ void UBYGLocalizationSettings::PostEditChangeProperty( struct FPropertyChangedEv
 		|| ( PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED( UBYGLocalizationSettings, PrimaryLocalizationDirectory ) )
 		|| ( PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED( UBYGLocalizationSettings, AdditionalLocalizationDirectories ) )
 		|| ( PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED( UBYGLocalizationSettings, bIncludeSubdirectories ) )
+		|| ( PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED( UBYGLocalizationSettings, MaxSubdirectoryDepth ) )
 		|| ( PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED( UBYGLocalizationSettings, FilenamePrefix ) )
 		|| ( PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED( UBYGLocalizationSettings, FilenameSuffix ) )
 		|| ( PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED( UBYGLocalizationSettings, PrimaryExtension ) )
@@ -59,6 +60,11 @@ void UBYGLocalizationSettings::PostEditChangeProperty( struct FPropertyChangedEv
 	{
 		FBYGLocalizationModule::Get().ReloadLocalizations();
 	}
+	else if ( PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED( UBYGLocalizationSettings, bHotReloadInEditor )
+		|| PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED( UBYGLocalizationSettings, bHotReloadInDevelopmentBuilds ) )
+	{
+		FBYGLocalizationModule::Get().RestartWatchingFiles();
+	}
 
 	Super::PostEditChangeProperty( PropertyChangedEvent );
 
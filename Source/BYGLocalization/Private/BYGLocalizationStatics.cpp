@@ -5,6 +5,8 @@
 #include "BYGLocalizationSettings.h"
 #include "BYGLocalizationModule.h"
 #include "BYGLocalization.h"
+#include "BYGGameTextCache.h"
+#include "BYGStringTableLoader.h"
 
 #include "Internationalization/StringTableCore.h"
 #include "Internationalization/StringTableRegistry.h"
@@ -54,39 +56,121 @@ bool GetTextFromTable( const FString& TableName, const FString& Key, FText& Foun
 	return false;
 }
 
-FText UBYGLocalizationStatics::GetGameText( const FString& Key )
+// Looks the key up in the registry every time, logging anything missing
+static bool GetGameTextUncached( const FString& Key, FText& Result )
 {
 	const UBYGLocalizationSettings* Settings = GetDefault<UBYGLocalizationSettings>();
 
-	FText Result;
 	bool bFound = GetTextFromTable( Settings->StringtableID, Key, Result );
 	if ( !bFound )
 	{
 		// Fall back to English if we're not using English and we didn't get the key in the non-English locale  
 		bFound = GetTextFromTable( Settings->PrimaryLanguageCode, Key, Result );
 	}
+	return bFound;
+}
+
+FText UBYGLocalizationStatics::GetGameText( const FString& Key )
+{
+	FText Result;
+	if ( IsInGameThread() && FBYGGameTextCache::Get().Find( Key, Result ) )
+		return Result;
+
+	// Missing keys go the slow way so they are still logged and get the compact error text
+	GetGameTextUncached( Key, Result );
 	return Result;
 }
 
-bool UBYGLocalizationStatics::SetLocalizationFromFile( const FString& Path )
+int32 UBYGLocalizationStatics::GetGameTexts( const TArray<FString>& Keys, TArray<FText>& Texts, TArray<bool>& Missing )
 {
-	const UBYGLocalizationSettings* Settings = GetDefault<UBYGLocalizationSettings>();
+	TBitArray<> MissingBits;
+	const int32 NumMissing = GetGameTextBatch( Keys, Texts, MissingBits );
 
-	FStringTableRegistry::Get().UnregisterStringTable( FName( *Settings->StringtableID ) );
-	FStringTableRegistry::Get().Internal_LocTableFromFile(
-		FName( *Settings->StringtableID ),
-		Settings->StringtableNamespace,
-		Path,
-		FPaths::ProjectContentDir() 
-	);
+	Missing.SetNumUninitialized( MissingBits.Num() );
+	for ( int32 i = 0; i < MissingBits.Num(); ++i )
+	{
+		Missing[ i ] = MissingBits[ i ];
+	}
+	return NumMissing;
+}
+
+int32 UBYGLocalizationStatics::GetGameTextBatch( const TArray<FString>& Keys, TArray<FText>& OutTexts, TBitArray<>& OutMissing )
+{
+	if ( IsInGameThread() )
+	{
+		const int32 NumMissing = FBYGGameTextCache::Get().FindBatch( Keys, OutTexts, OutMissing );
+		// Same as GetGameText, missing keys are logged and get the compact error text
+		for ( TConstSetBitIterator<> It( OutMissing ); It; ++It )
+		{
+			GetGameTextUncached( Keys[ It.GetIndex() ], OutTexts[ It.GetIndex() ] );
+		}
+		return NumMissing;
+	}
+
+	int32 NumMissing = 0;
+	OutTexts.Reset( Keys.Num() );
+	OutTexts.AddDefaulted( Keys.Num() );
+	OutMissing.Init( false, Keys.Num() );
+	for ( int32 i = 0; i < Keys.Num(); ++i )
+	{
+		if ( !GetGameTextUncached( Keys[ i ], OutTexts[ i ] ) )
+		{
+			OutMissing[ i ] = true;
+			++NumMissing;
+		}
+	}
+	return NumMissing;
+}
 
+// Only use UE4's locale changing system outside of the editor, or stuff gets weird
+static void SetCultureFromFile( const FString& Path )
+{
 #if !WITH_EDITOR
-	// Only use UE4's locale changing system outside of the editor, or stuff gets weird
 	const FBYGLocaleInfo Basic = FBYGLocalizationModule::Get().GetLocalization()->GetCultureFromFilename( Path );
 	FInternationalization::Get().SetCurrentCulture( Basic.LocaleCode );
 	FInternationalization::Get().SetCurrentLanguageAndLocale( Basic.LocaleCode );
 #endif
+}
+
+bool UBYGLocalizationStatics::SetLocalizationFromFile( const FString& Path )
+{
+	const UBYGLocalizationSettings* Settings = GetDefault<UBYGLocalizationSettings>();
+
+	FBYGStringTableLoader::RegisterStringTable(
+		FName( *Settings->StringtableID ),
+		Path,
+		Settings->StringtableNamespace,
+		Settings->bUseCompiledLocalizations
+	);
+
+	SetCultureFromFile( Path );
 
 	return true;
 }
 
+void UBYGLocalizationStatics::SetLocalizationFromFileAsync( const FString& Path, const FBYGOnLocalizationSetSignature& OnComplete )
+{
+	const UBYGLocalizationSettings* Settings = GetDefault<UBYGLocalizationSettings>();
+
+	FBYGStringTableLoader::RegisterStringTableAsync(
+		FName( *Settings->StringtableID ),
+		Path,
+		Settings->StringtableNamespace,
+		Settings->bUseCompiledLocalizations,
+		[Path, OnComplete]( bool bSuccess )
+		{
+			if ( bSuccess )
+			{
+				SetCultureFromFile( Path );
+			}
+			OnComplete.ExecuteIfBound( bSuccess );
+		}
+	);
+}
+
+void UBYGLocalizationStatics::PreloadLocalizationFromFile( const FString& Path )
+{
+	const UBYGLocalizationSettings* Settings = GetDefault<UBYGLocalizationSettings>();
+
+	FBYGStringTableLoader::PreloadStringTable( Path, Settings->StringtableNamespace, Settings->bUseCompiledLocalizations );
+}
@@ -0,0 +1,135 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#include "BYGStatsCache.h"
+#include "BYGLocalizationCoreMinimal.h"
+#include "BYGLocalizationSettings.h"
+
+#include "Dom/JsonObject.h"
+#include "Hash/CityHash.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+namespace BYGStatsCache
+{
+	// Increase this if anything about how stats are counted changes, so old caches are ignored
+	static const int32 Version = 1;
+
+	static FString HashToString( uint64 Hash )
+	{
+		return FString::Printf( TEXT( "%016llx" ), Hash );
+	}
+
+	static uint64 HashFromString( const FString& Str )
+	{
+		return FCString::Strtoui64( *Str, nullptr, 16 );
+	}
+}
+
+FString FBYGStatsCache::GetDefaultPath()
+{
+	return FPaths::Combine( FPaths::ProjectSavedDir(), TEXT( "BYGLocalization" ), TEXT( "StatsCache.json" ) );
+}
+
+bool FBYGStatsCache::Load( const FString& Path, const UBYGLocalizationSettings& Settings )
+{
+	SettingsHash = HashStatusSettings( Settings );
+	Entries.Empty();
+
+	FString JsonString;
+	if ( !FFileHelper::LoadFileToString( JsonString, *Path, FFileHelper::EHashOptions::None, FILEREAD_Silent ) )
+		return false;
+
+	TSharedPtr<FJsonObject> Root;
+	if ( !FJsonSerializer::Deserialize( TJsonReaderFactory<>::Create( JsonString ), Root ) || !Root.IsValid() )
+	{
+		UE_LOG( LogBYGLocalization, Warning, TEXT( "Could not read stats cache '%s', all files will be scanned" ), *Path );
+		return false;
+	}
+
+	if ( Root->GetIntegerField( TEXT( "Version" ) ) != BYGStatsCache::Version
+		|| BYGStatsCache::HashFromString( Root->GetStringField( TEXT( "SettingsHash" ) ) ) != SettingsHash )
+		return false;
+
+	const TSharedPtr<FJsonObject>* Files = nullptr;
+	if ( !Root->TryGetObjectField( TEXT( "Files" ), Files ) )
+		return false;
+
+	for ( const TPair<FString, TSharedPtr<FJsonValue>>& Pair : ( *Files )->Values )
+	{
+		const TSharedPtr<FJsonObject>* File = nullptr;
+		if ( !Pair.Value->TryGetObject( File ) )
+			continue;
+
+		FEntry Entry;
+		Entry.Size = FCString::Atoi64( *( *File )->GetStringField( TEXT( "Size" ) ) );
+		Entry.Timestamp = FDateTime( FCString::Atoi64( *( *File )->GetStringField( TEXT( "Timestamp" ) ) ) );
+		Entry.Hash = BYGStatsCache::HashFromString( ( *File )->GetStringField( TEXT( "Hash" ) ) );
+
+		const TArray<TSharedPtr<FJsonValue>>* Counts = nullptr;
+		if ( !( *File )->TryGetArrayField( TEXT( "Counts" ), Counts ) || Counts->Num() != BYGLocStats::NumStatuses )
+			continue;
+		for ( int32 i = 0; i < BYGLocStats::NumStatuses; ++i )
+		{
+			Entry.Stats.Counts[ i ] = static_cast<int32>( ( *Counts )[ i ]->AsNumber() );
+		}
+
+		Entries.Add( Pair.Key, Entry );
+	}
+
+	return true;
+}
+
+bool FBYGStatsCache::Save( const FString& Path ) const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField( TEXT( "Version" ), BYGStatsCache::Version );
+	Root->SetStringField( TEXT( "SettingsHash" ), BYGStatsCache::HashToString( SettingsHash ) );
+
+	TSharedRef<FJsonObject> Files = MakeShared<FJsonObject>();
+	for ( const TPair<FString, FEntry>& Pair : Entries )
+	{
+		// Sizes and timestamps are strings for the same reason as hashes, JSON numbers are doubles
+		TSharedRef<FJsonObject> File = MakeShared<FJsonObject>();
+		File->SetStringField( TEXT( "Size" ), LexToString( Pair.Value.Size ) );
+		File->SetStringField( TEXT( "Timestamp" ), LexToString( Pair.Value.Timestamp.GetTicks() ) );
+		File->SetStringField( TEXT( "Hash" ), BYGStatsCache::HashToString( Pair.Value.Hash ) );
+
+		TArray<TSharedPtr<FJsonValue>> Counts;
+		for ( int32 i = 0; i < BYGLocStats::NumStatuses; ++i )
+		{
+			Counts.Add( MakeShared<FJsonValueNumber>( Pair.Value.Stats.Counts[ i ] ) );
+		}
+		File->SetArrayField( TEXT( "Counts" ), Counts );
+
+		Files->SetObjectField( Pair.Key, File );
+	}
+	Root->SetObjectField( TEXT( "Files" ), Files );
+
+	FString JsonString;
+	if ( !FJsonSerializer::Serialize( Root, TJsonWriterFactory<>::Create( &JsonString ) ) )
+		return false;
+
+	return FFileHelper::SaveStringToFile( JsonString, *Path );
+}
+
+const FBYGStatsCache::FEntry* FBYGStatsCache::FindUnchanged( const FString& FilePath, int64 Size, const FDateTime& Timestamp ) const
+{
+	const FEntry* Entry = Entries.Find( FilePath );
+	if ( Entry && Entry->Size == Size && Entry->Timestamp == Timestamp )
+		return Entry;
+	return nullptr;
+}
+
+uint64 FBYGStatsCache::HashStatusSettings( const UBYGLocalizationSettings& Settings )
+{
+	// Only the settings GetLocalizationStats uses to classify rows
+	const FString Combined = FString::Printf( TEXT( "%s|%s|%s" ),
+		*Settings.NewStatus,
+		*Settings.ModifiedStatusLeft,
+		*Settings.DeprecatedStatus );
+
+	return CityHash64( reinterpret_cast<const char*>( *Combined ), Combined.Len() * sizeof( TCHAR ) );
+}
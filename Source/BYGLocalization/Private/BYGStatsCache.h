@@ -0,0 +1,41 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BYGLocalization/Public/BYGLocalization.h"
+
+// Remembers the stats of localization files between runs of the stats window, so only files that changed need
+// to be scanned again.
+// A file whose size and modification time match its entry is trusted as-is. If either changed but the contents
+// hash the same, the stats are still reused. Stored as JSON in Saved/BYGLocalization/, hashes as hex strings.
+class BYGLOCALIZATION_API FBYGStatsCache
+{
+public:
+	struct FEntry
+	{
+		int64 Size = 0;
+		FDateTime Timestamp;
+		uint64 Hash = 0;
+		BYGLocStats Stats;
+	};
+
+	static FString GetDefaultPath();
+
+	// Entries saved with different status settings are thrown away, their counts would be wrong
+	bool Load( const FString& Path, const UBYGLocalizationSettings& Settings );
+	bool Save( const FString& Path ) const;
+
+	// Returns the entry for the file if its size and modification time haven't changed
+	const FEntry* FindUnchanged( const FString& FilePath, int64 Size, const FDateTime& Timestamp ) const;
+	const FEntry* Find( const FString& FilePath ) const { return Entries.Find( FilePath ); }
+
+	void Add( const FString& FilePath, const FEntry& Entry ) { Entries.Add( FilePath, Entry ); }
+
+protected:
+	static uint64 HashStatusSettings( const UBYGLocalizationSettings& Settings );
+
+	uint64 SettingsHash = 0;
+	// Keyed by full path
+	TMap<FString, FEntry> Entries;
+};
@@ -0,0 +1,81 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StringView.h"
+#include "BYGLocalization.h"
+#include "BYGLocalizationSettings.h"
+
+// Classifies the Status column of a row without creating any strings.
+// The status prefixes are lower-cased once up-front, matching is case-insensitive like FString::StartsWith,
+// and the first character is checked before comparing the rest so most rows are rejected in one compare.
+// UTF-8 cells are compared byte by byte against UTF-8 copies of the prefixes, only ASCII letters are case-insensitive there
+class FBYGStatusMatcher
+{
+public:
+	explicit FBYGStatusMatcher( const UBYGLocalizationSettings& Settings )
+	{
+		// Order matters, it matches the order we have always tested the prefixes in
+		Prefixes[ 0 ].Init( Settings.DeprecatedStatus, EBYGLocEntryStatus::Deprecated );
+		Prefixes[ 1 ].Init( Settings.ModifiedStatusLeft, EBYGLocEntryStatus::Modified );
+		Prefixes[ 2 ].Init( Settings.NewStatus, EBYGLocEntryStatus::New );
+	}
+
+	EBYGLocEntryStatus Classify( const FStringView& Status ) const
+	{
+		return Classify( Status.GetData(), Status.Len(), []( const FPrefix& Prefix ) { return FStringView( Prefix.Text ); }, []( TCHAR Ch ) { return FChar::ToLower( Ch ); } );
+	}
+	EBYGLocEntryStatus Classify( const TStringView<ANSICHAR>& Status ) const
+	{
+		return Classify( Status.GetData(), Status.Len(), []( const FPrefix& Prefix ) { return TStringView<ANSICHAR>( Prefix.UTF8Text.GetData(), Prefix.UTF8Text.Num() ); },
+			[]( ANSICHAR Ch ) { return Ch >= 'A' && Ch <= 'Z' ? static_cast<ANSICHAR>( Ch - 'A' + 'a' ) : Ch; } );
+	}
+
+protected:
+	struct FPrefix
+	{
+		FString Text;
+		// Not null-terminated
+		TArray<ANSICHAR> UTF8Text;
+		EBYGLocEntryStatus Status = EBYGLocEntryStatus::None;
+
+		void Init( const FString& InText, EBYGLocEntryStatus InStatus )
+		{
+			Text = InText.ToLower();
+			const FTCHARToUTF8 Converted( *Text, Text.Len() );
+			UTF8Text.Append( Converted.Get(), Converted.Length() );
+			Status = InStatus;
+		}
+	};
+
+	template <typename CharType, typename GetPrefixType, typename ToLowerType>
+	EBYGLocEntryStatus Classify( const CharType* Status, int32 StatusLen, GetPrefixType GetPrefix, ToLowerType ToLower ) const
+	{
+		if ( StatusLen == 0 )
+			return EBYGLocEntryStatus::None;
+
+		const CharType First = ToLower( Status[ 0 ] );
+		for ( const FPrefix& Prefix : Prefixes )
+		{
+			const TStringView<CharType> PrefixText = GetPrefix( Prefix );
+			const int32 PrefixLen = PrefixText.Len();
+			// Empty prefixes never match, same as FString::StartsWith
+			if ( PrefixLen == 0 || PrefixLen > StatusLen || PrefixText[ 0 ] != First )
+				continue;
+
+			int32 i = 1;
+			while ( i < PrefixLen && ToLower( Status[ i ] ) == PrefixText[ i ] )
+			{
+				++i;
+			}
+			if ( i == PrefixLen )
+			{
+				return Prefix.Status;
+			}
+		}
+		return EBYGLocEntryStatus::None;
+	}
+
+	FPrefix Prefixes[ 3 ];
+};
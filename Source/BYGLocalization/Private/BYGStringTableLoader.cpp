@@ -0,0 +1,694 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#include "BYGStringTableLoader.h"
+#include "BYGCSVParser.h"
+#include "BYGLocalizationCoreMinimal.h"
+#include "BYGUpdateManifest.h"
+
+#include "Async/Async.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Internationalization/StringTableCore.h"
+#include "Internationalization/StringTableRegistry.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+const TCHAR* FBYGStringTableLoader::CompiledExtension = TEXT( "bygloc" );
+uint32 FBYGStringTableLoader::TableGeneration = 0;
+TMap<FName, FString> FBYGStringTableLoader::LoadedTablePaths;
+TMap<FString, FBYGStringTableLoader::FPreload> FBYGStringTableLoader::Preloads;
+TMap<FName, uint32> FBYGStringTableLoader::LatestAsyncRequests;
+uint32 FBYGStringTableLoader::AsyncRequestCounter = 0;
+const int32 FBYGStringTableLoader::MaxPreloads = 4;
+
+namespace BYGCompiledFormat
+{
+	static const uint32 Magic = 0x4C475942; // "BYGL"
+	// Bump this whenever the layout changes, older files will be treated as stale
+	static const uint32 Version = 2;
+
+	struct FHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		int64 SourceSize;
+		int64 SourceTimestamp;
+		uint64 SourceHash;
+		uint32 NumEntries;
+		uint32 IndexOffset;
+		uint32 BlobOffset;
+		// In UTF-16 code units
+		uint32 BlobLength;
+	};
+	static_assert( sizeof( FHeader ) == 48, "Compiled localization header layout changed" );
+
+	// Offsets and lengths are in UTF-16 code units from the start of the blob.
+	// Entries are in file order, duplicate keys are left in and the last one wins, same as when loading the CSV
+	struct FIndexEntry
+	{
+		uint32 KeyOffset;
+		uint32 KeyLength;
+		uint32 ValueOffset;
+		uint32 ValueLength;
+	};
+	static_assert( sizeof( FIndexEntry ) == 16, "Compiled localization index layout changed" );
+
+	static FString ToString( const UTF16CHAR* Blob, uint32 Offset, uint32 Length )
+	{
+		if ( Length == 0 )
+			return FString();
+		FUTF16ToTCHAR Converted( Blob + Offset, Length );
+		return FString( Converted.Length(), Converted.Get() );
+	}
+}
+
+FString FBYGStringTableLoader::GetFullPath( const FString& Path )
+{
+	if ( !FPaths::IsRelative( Path ) && FPaths::FileExists( Path ) )
+	{
+		return Path;
+	}
+	FString FullPath = FPaths::Combine( FPaths::ProjectContentDir(), Path );
+	FPaths::RemoveDuplicateSlashes( FullPath );
+	return FullPath;
+}
+
+FString FBYGStringTableLoader::GetCompiledPath( const FString& FullPath )
+{
+	// Appended rather than swapped, so loc_fr.csv and loc_fr.txt don't share a compiled file
+	return FullPath + TEXT( "." ) + CompiledExtension;
+}
+
+FStringTablePtr FBYGStringTableLoader::BuildStringTable( const FString& Path, const FString& Namespace, bool bUseCompiled )
+{
+	BYG_SCOPE_CYCLE_COUNTER( BuildStringTable );
+	BYG_LLM_SCOPE();
+
+	const FString FullPath = GetFullPath( Path );
+
+	FStringTableRef Table = FStringTable::NewStringTable();
+	Table->SetNamespace( Namespace );
+
+	if ( bUseCompiled && LoadCompiled( FullPath, Table ) )
+	{
+		return Table;
+	}
+
+	FSourceFile Source;
+	bool bWriteCompiled = false;
+#if WITH_EDITOR
+	// Packaged builds use what the cook compiled, they may not be able to write next to the CSV.
+	// Stat before reading, so a change while we read makes the compiled file stale rather than wrong
+	bWriteCompiled = bUseCompiled && GetSourceFile( FullPath, Source );
+#endif
+
+	FKeyValueArray Pairs;
+	if ( !ParseCSV( FullPath, Pairs, bWriteCompiled ? &Source.Hash : nullptr ) )
+	{
+		return nullptr;
+	}
+
+	for ( const TPair<FString, FString>& Pair : Pairs )
+	{
+		Table->SetSourceString( Pair.Key, Pair.Value );
+	}
+
+	// Not fatal, we'll just parse the CSV again next time
+	if ( bWriteCompiled && !WriteCompiled( FullPath, Pairs, Source ) )
+	{
+		UE_LOG( LogBYGLocalization, Verbose, TEXT( "Could not write compiled localization for '%s'" ), *FullPath );
+	}
+
+	return Table;
+}
+
+bool FBYGStringTableLoader::RegisterStringTable( const FName TableID, const FString& Path, const FString& Namespace, bool bUseCompiled )
+{
+	check( IsInGameThread() );
+	BYG_LLM_SCOPE();
+
+	// Anything still loading for this ID is now out of date
+	LatestAsyncRequests.Remove( TableID );
+
+	FStringTablePtr Table = BuildStringTable( Path, Namespace, bUseCompiled );
+	const bool bSucceeded = Table.IsValid();
+	if ( !bSucceeded )
+	{
+		UE_LOG( LogBYGLocalization, Warning, TEXT( "Failed to load localization '%s', registering empty string table '%s'" ), *Path, *TableID.ToString() );
+		Table = FStringTable::NewStringTable();
+		Table->SetNamespace( Namespace );
+	}
+
+	ReplaceStringTable( TableID, Table.ToSharedRef(), GetFullPath( Path ) );
+
+	return bSucceeded;
+}
+
+void FBYGStringTableLoader::UnregisterStringTable( const FName TableID )
+{
+	check( IsInGameThread() );
+
+	LatestAsyncRequests.Remove( TableID );
+
+	FStringTableRegistry::Get().UnregisterStringTable( TableID );
+	LoadedTablePaths.Remove( TableID );
+	++TableGeneration;
+}
+
+void FBYGStringTableLoader::ReplaceStringTable( const FName TableID, FStringTableRef Table, const FString& FullPath )
+{
+	check( IsInGameThread() );
+	BYG_SCOPE_CYCLE_COUNTER( RegisterStringTable );
+
+	FStringTableRegistry& Registry = FStringTableRegistry::Get();
+	Registry.UnregisterStringTable( TableID );
+	Registry.RegisterStringTable( TableID, Table );
+	LoadedTablePaths.Add( TableID, FullPath );
+	++TableGeneration;
+}
+
+void FBYGStringTableLoader::RegisterStringTableAsync( const FName TableID, const FString& Path, const FString& Namespace, bool bUseCompiled, TFunction<void( bool )> OnComplete )
+{
+	check( IsInGameThread() );
+
+	const uint32 RequestID = ++AsyncRequestCounter;
+	LatestAsyncRequests.Add( TableID, RequestID );
+
+	const FString FullPath = GetFullPath( Path );
+	TFuture<FStringTablePtr> PreloadedTable;
+	if ( FPreload* Preload = Preloads.Find( FullPath ) )
+	{
+		if ( Preload->Namespace == Namespace && Preload->bUseCompiled == bUseCompiled )
+		{
+			PreloadedTable = MoveTemp( Preload->Table );
+		}
+		Preloads.Remove( FullPath );
+	}
+
+	if ( PreloadedTable.IsValid() )
+	{
+		// Runs on whichever thread finishes the preload, or right here if it already has, rather than tying up
+		// another worker waiting for it
+		PreloadedTable.Next( [TableID, Path, RequestID, OnComplete = MoveTemp( OnComplete )]( FStringTablePtr Table ) mutable
+		{
+			AsyncTask( ENamedThreads::GameThread, [TableID, Path, RequestID, Table, OnComplete = MoveTemp( OnComplete )]()
+			{
+				CompleteAsyncRequest( TableID, Path, RequestID, Table, OnComplete );
+			} );
+		} );
+		return;
+	}
+
+	Async( EAsyncExecution::ThreadPool, [TableID, Path, Namespace, bUseCompiled, RequestID, OnComplete = MoveTemp( OnComplete )]() mutable
+	{
+		FStringTablePtr Table = BuildStringTable( Path, Namespace, bUseCompiled );
+
+		AsyncTask( ENamedThreads::GameThread, [TableID, Path, RequestID, Table, OnComplete = MoveTemp( OnComplete )]()
+		{
+			CompleteAsyncRequest( TableID, Path, RequestID, Table, OnComplete );
+		} );
+	} );
+}
+
+void FBYGStringTableLoader::CompleteAsyncRequest( const FName TableID, const FString& Path, uint32 RequestID, FStringTablePtr Table, const TFunction<void( bool )>& OnComplete )
+{
+	check( IsInGameThread() );
+	BYG_LLM_SCOPE();
+
+	const uint32* LatestRequestID = LatestAsyncRequests.Find( TableID );
+	if ( !LatestRequestID || *LatestRequestID != RequestID )
+	{
+		UE_LOG( LogBYGLocalization, Log, TEXT( "Dropping localization '%s', a newer one was requested for string table '%s'" ), *Path, *TableID.ToString() );
+		if ( OnComplete )
+		{
+			OnComplete( false );
+		}
+		return;
+	}
+	LatestAsyncRequests.Remove( TableID );
+
+	const bool bSucceeded = Table.IsValid();
+	if ( !bSucceeded )
+	{
+		// Same as RegisterStringTable, but we keep the old table rather than swap in an empty one
+		UE_LOG( LogBYGLocalization, Warning, TEXT( "Failed to load localization '%s', keeping the current string table '%s'" ), *Path, *TableID.ToString() );
+	}
+	else
+	{
+		ReplaceStringTable( TableID, Table.ToSharedRef(), GetFullPath( Path ) );
+	}
+
+	if ( OnComplete )
+	{
+		OnComplete( bSucceeded );
+	}
+}
+
+void FBYGStringTableLoader::PreloadStringTable( const FString& Path, const FString& Namespace, bool bUseCompiled )
+{
+	check( IsInGameThread() );
+
+	const FString FullPath = GetFullPath( Path );
+
+	// Preloads nobody claims would otherwise keep their tables alive forever
+	Preloads.Remove( FullPath );
+	while ( Preloads.Num() >= MaxPreloads )
+	{
+		const FString* Oldest = nullptr;
+		uint32 OldestRequestID = MAX_uint32;
+		for ( const TPair<FString, FPreload>& Pair : Preloads )
+		{
+			if ( Pair.Value.RequestID < OldestRequestID )
+			{
+				Oldest = &Pair.Key;
+				OldestRequestID = Pair.Value.RequestID;
+			}
+		}
+		UE_LOG( LogBYGLocalization, Verbose, TEXT( "Dropping unused preloaded localization '%s'" ), **Oldest );
+		Preloads.Remove( FString( *Oldest ) );
+	}
+
+	FPreload Preload;
+	Preload.Namespace = Namespace;
+	Preload.bUseCompiled = bUseCompiled;
+	Preload.RequestID = ++AsyncRequestCounter;
+	Preload.Table = Async( EAsyncExecution::ThreadPool, [Path, Namespace, bUseCompiled]()
+	{
+		return BuildStringTable( Path, Namespace, bUseCompiled );
+	} );
+	Preloads.Add( FullPath, MoveTemp( Preload ) );
+}
+
+void FBYGStringTableLoader::PatchStringTablesAsync( const FString& Path )
+{
+	check( IsInGameThread() );
+
+	const FString FullPath = GetFullPath( Path );
+
+	// Hold on to the tables themselves, so we can tell if they were replaced while the file was being read
+	TArray<TPair<FName, FStringTableConstPtr>> Tables;
+	for ( const TPair<FName, FString>& Pair : LoadedTablePaths )
+	{
+		if ( FPaths::IsSamePath( Pair.Value, FullPath ) )
+		{
+			FStringTableConstPtr Table = FStringTableRegistry::Get().FindStringTable( Pair.Key );
+			if ( Table.IsValid() )
+			{
+				Tables.Emplace( Pair.Key, Table );
+			}
+		}
+	}
+	if ( Tables.Num() == 0 )
+		return;
+
+	Async( EAsyncExecution::ThreadPool, [FullPath, Tables]()
+	{
+		BYG_SCOPE_CYCLE_COUNTER( PatchStringTables );
+		BYG_LLM_SCOPE();
+
+		// The file may be half-written, keep the tables as they are until the next change
+		FKeyValueArray Pairs;
+		if ( !ParseCSV( FullPath, Pairs ) )
+			return;
+
+		TArray<FTablePatch> Patches;
+		Patches.SetNum( Tables.Num() );
+		for ( int32 i = 0; i < Tables.Num(); ++i )
+		{
+			ComputePatch( *Tables[ i ].Value, Pairs, Patches[ i ] );
+		}
+
+		AsyncTask( ENamedThreads::GameThread, [FullPath, Tables, Patches = MoveTemp( Patches )]()
+		{
+			BYG_LLM_SCOPE();
+			for ( int32 i = 0; i < Tables.Num(); ++i )
+			{
+				const FName TableID = Tables[ i ].Key;
+				if ( FStringTableRegistry::Get().FindStringTable( TableID ) != Tables[ i ].Value )
+				{
+					UE_LOG( LogBYGLocalization, Log, TEXT( "Not patching string table '%s', it was replaced while '%s' was being read" ), *TableID.ToString(), *FullPath );
+					continue;
+				}
+				if ( Patches[ i ].IsEmpty() )
+					continue;
+
+				ApplyPatch( ConstCastSharedRef<FStringTable>( Tables[ i ].Value.ToSharedRef() ), Patches[ i ] );
+				UE_LOG( LogBYGLocalization, Log, TEXT( "Patched string table '%s' from '%s', %d rows added or changed, %d removed" ),
+					*TableID.ToString(), *FullPath, Patches[ i ].Changed.Num(), Patches[ i ].Removed.Num() );
+			}
+		} );
+	} );
+}
+
+void FBYGStringTableLoader::ComputePatch( const FStringTable& Table, const TArray<TPair<FString, FString>>& Pairs, FTablePatch& OutPatch )
+{
+	BYG_SCOPE_CYCLE_COUNTER( ComputePatch );
+
+	// String table keys are case-sensitive, the default FString key funcs are not
+	struct FCaseSensitiveKeyFuncs : BaseKeyFuncs<TPair<FString, FString>, FString, false>
+	{
+		static const FString& GetSetKey( const TPair<FString, FString>& Element ) { return Element.Key; }
+		static bool Matches( const FString& A, const FString& B ) { return A.Equals( B, ESearchCase::CaseSensitive ); }
+		static uint32 GetKeyHash( const FString& Key ) { return FCrc::StrCrc32( *Key ); }
+	};
+
+	// Same as loading the file, the last row with a key wins
+	TMap<FString, FString, FDefaultSetAllocator, FCaseSensitiveKeyFuncs> NewValues;
+	NewValues.Reserve( Pairs.Num() );
+	for ( const TPair<FString, FString>& Pair : Pairs )
+	{
+		NewValues.Add( Pair.Key, Pair.Value );
+	}
+
+	for ( const TPair<FString, FString>& Pair : NewValues )
+	{
+		FStringTableEntryConstPtr Entry = Table.FindEntry( Pair.Key );
+		if ( !Entry.IsValid() || !Entry->GetSourceString().Equals( Pair.Value, ESearchCase::CaseSensitive ) )
+		{
+			OutPatch.Changed.Emplace( Pair.Key, Pair.Value );
+		}
+	}
+
+	Table.EnumerateSourceStrings( [&NewValues, &OutPatch]( const FString& Key, const FString& SourceString ) -> bool
+	{
+		if ( !NewValues.Contains( Key ) )
+		{
+			OutPatch.Removed.Add( Key );
+		}
+		return true;
+	} );
+}
+
+void FBYGStringTableLoader::ApplyPatch( FStringTableRef Table, const FTablePatch& Patch )
+{
+	check( IsInGameThread() );
+	BYG_LLM_SCOPE();
+
+	// Changed rows get a new entry and the old one is disowned, so text bound to it finds the new one the next
+	// time it is displayed
+	for ( const TPair<FString, FString>& Pair : Patch.Changed )
+	{
+		Table->SetSourceString( Pair.Key, Pair.Value );
+	}
+	for ( const FString& Key : Patch.Removed )
+	{
+		Table->RemoveSourceString( Key );
+	}
+
+	// FBYGGameTextCache holds texts from the old entries
+	++TableGeneration;
+}
+
+void FBYGStringTableLoader::GetTableMemory( TArray<FTableMemory>& OutTables )
+{
+	check( IsInGameThread() );
+
+	OutTables.Reset( LoadedTablePaths.Num() );
+	for ( const TPair<FName, FString>& Pair : LoadedTablePaths )
+	{
+		FTableMemory Table;
+		if ( GetTableMemory( Pair.Key, Table ) )
+		{
+			OutTables.Add( MoveTemp( Table ) );
+		}
+	}
+}
+
+bool FBYGStringTableLoader::GetTableMemory( const FName TableID, FTableMemory& OutTable )
+{
+	check( IsInGameThread() );
+
+	FStringTableConstPtr Table = FStringTableRegistry::Get().FindStringTable( TableID );
+	if ( !Table.IsValid() )
+		return false;
+
+	OutTable = FTableMemory();
+	OutTable.TableID = TableID;
+	if ( const FString* Path = LoadedTablePaths.Find( TableID ) )
+	{
+		OutTable.Path = *Path;
+	}
+
+	Table->EnumerateSourceStrings( [&OutTable, &Table]( const FString& Key, const FString& SourceString )
+	{
+		++OutTable.NumKeys;
+		OutTable.KeyBytes += Key.GetAllocatedSize();
+		OutTable.StringBytes += SourceString.GetAllocatedSize();
+		FStringTableEntryConstPtr Entry = Table->FindEntry( Key );
+		if ( Entry.IsValid() && Entry->GetDisplayString().IsValid() )
+		{
+			OutTable.StringBytes += sizeof( FString ) + Entry->GetDisplayString()->GetAllocatedSize();
+		}
+		return true;
+	} );
+
+	// Each entry is its own shared allocation, and the map holds a key, a shared ref and a hash link per entry,
+	// with roughly one hash bucket per entry
+	const SIZE_T BytesPerEntry = sizeof( FStringTableEntry ) + 2 * sizeof( void* )
+		+ sizeof( FString ) + sizeof( FStringTableEntryConstPtr ) + sizeof( FSetElementId ) + sizeof( int32 )
+		+ sizeof( FSetElementId );
+	OutTable.IndexBytes = OutTable.NumKeys * BytesPerEntry;
+
+	return true;
+}
+
+bool FBYGStringTableLoader::Compile( const FString& FullPath )
+{
+	FSourceFile Source;
+	FKeyValueArray Pairs;
+	return GetSourceFile( FullPath, Source )
+		&& ParseCSV( FullPath, Pairs, &Source.Hash )
+		&& WriteCompiled( FullPath, Pairs, Source );
+}
+
+int32 FBYGStringTableLoader::CompileAll( const TArray<FString>& Paths )
+{
+	int32 NumCompiled = 0;
+	for ( const FString& Path : Paths )
+	{
+		const FString FullPath = GetFullPath( Path );
+		if ( Compile( FullPath ) )
+		{
+			++NumCompiled;
+		}
+		else
+		{
+			UE_LOG( LogBYGLocalization, Warning, TEXT( "Could not compile localization '%s', it will be parsed as CSV when loaded" ), *FullPath );
+		}
+	}
+	UE_LOG( LogBYGLocalization, Log, TEXT( "Compiled %d of %d localization files" ), NumCompiled, Paths.Num() );
+	return NumCompiled;
+}
+
+namespace BYGStringTableCSV
+{
+	template <typename CharType>
+	static bool ParsePairs( TBYGCSVParser<CharType>& Parser, const FString& FullPath, TArray<TPair<FString, FString>>& OutPairs )
+	{
+		typedef TBYGCSVParser<CharType> FParser;
+		typename FParser::FRow Row;
+
+		// Same as FStringTable::ImportStrings, the Key and SourceString columns can be anywhere in the header
+		int32 KeyColumn = INDEX_NONE;
+		int32 SourceStringColumn = INDEX_NONE;
+		if ( Parser.ParseRow( Row ) )
+		{
+			for ( int32 i = 0; i < Row.Num(); ++i )
+			{
+				const FString Header = FParser::ToString( Row[ i ] );
+				if ( KeyColumn == INDEX_NONE && Header.Equals( TEXT( "Key" ), ESearchCase::IgnoreCase ) )
+				{
+					KeyColumn = i;
+				}
+				else if ( SourceStringColumn == INDEX_NONE && Header.Equals( TEXT( "SourceString" ), ESearchCase::IgnoreCase ) )
+				{
+					SourceStringColumn = i;
+				}
+			}
+		}
+		if ( KeyColumn == INDEX_NONE || SourceStringColumn == INDEX_NONE )
+		{
+			UE_LOG( LogBYGLocalization, Error, TEXT( "'%s' is missing a 'Key' or 'SourceString' column" ), *FullPath );
+			return false;
+		}
+
+		const int32 MinColumns = FMath::Max( KeyColumn, SourceStringColumn ) + 1;
+		while ( Parser.ParseRow( Row ) )
+		{
+			if ( Row.Num() < MinColumns || Row[ KeyColumn ].Len() == 0 )
+				continue;
+
+			// Only these two cells are ever converted from UTF-8.
+			// Escape sequences like \n are unescaped on import, same as Unreal's string table import
+			TPair<FString, FString>& Pair = OutPairs.AddDefaulted_GetRef();
+			Pair.Key = FParser::ToString( Row[ KeyColumn ] ).ReplaceEscapedCharWithChar();
+			Pair.Value = FParser::ToString( Row[ SourceStringColumn ] ).ReplaceEscapedCharWithChar();
+		}
+		BYG_INC_COUNTER( RowsParsed, OutPairs.Num() );
+
+		return true;
+	}
+}
+
+bool FBYGStringTableLoader::ParseCSV( const FString& FullPath, FKeyValueArray& OutPairs, uint64* OutHash )
+{
+	FBYGFileText File;
+	if ( !File.Load( *FullPath, 0, OutHash ) )
+	{
+		UE_LOG( LogBYGLocalization, Error, TEXT( "Failed to load file '%s'" ), *FullPath );
+		return false;
+	}
+
+	if ( File.IsUTF8() )
+	{
+		FBYGUTF8CSVParser Parser( File.GetUTF8(), File.GetUTF8Len() );
+		return BYGStringTableCSV::ParsePairs( Parser, FullPath, OutPairs );
+	}
+
+	FBYGCSVParser Parser( File.Wide );
+	return BYGStringTableCSV::ParsePairs( Parser, FullPath, OutPairs );
+}
+
+bool FBYGStringTableLoader::GetSourceFile( const FString& FullPath, FSourceFile& OutSource )
+{
+	const FFileStatData StatData = FPlatformFileManager::Get().GetPlatformFile().GetStatData( *FullPath );
+	if ( !StatData.bIsValid || StatData.bIsDirectory )
+		return false;
+	OutSource.Size = StatData.FileSize;
+	OutSource.Timestamp = StatData.ModificationTime.GetTicks();
+	return true;
+}
+
+bool FBYGStringTableLoader::LoadCompiled( const FString& FullPath, FStringTableRef Table )
+{
+	using namespace BYGCompiledFormat;
+
+	BYG_SCOPE_CYCLE_COUNTER( LoadCompiled );
+
+	FSourceFile Source;
+	if ( !GetSourceFile( FullPath, Source ) )
+		return false;
+
+	const FString CompiledPath = GetCompiledPath( FullPath );
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if ( !PlatformFile.FileExists( *CompiledPath ) )
+		return false;
+
+	// Not every platform (or pak file) supports mapping, so keep a plain read as a fallback
+	TUniquePtr<IMappedFileHandle> MappedFile( PlatformFile.OpenMapped( *CompiledPath ) );
+	TUniquePtr<IMappedFileRegion> MappedRegion( MappedFile ? MappedFile->MapRegion() : nullptr );
+	TArray<uint8> FileData;
+	const uint8* Data = nullptr;
+	int64 DataSize = 0;
+	if ( MappedRegion )
+	{
+		Data = MappedRegion->GetMappedPtr();
+		DataSize = MappedRegion->GetMappedSize();
+	}
+	else if ( FFileHelper::LoadFileToArray( FileData, *CompiledPath, FILEREAD_Silent ) )
+	{
+		Data = FileData.GetData();
+		DataSize = FileData.Num();
+	}
+
+	if ( !Data || DataSize < (int64)sizeof( FHeader ) )
+		return false;
+	BYG_INC_BYTES_COUNTER( BytesRead, DataSize );
+
+	FHeader Header;
+	FMemory::Memcpy( &Header, Data, sizeof( FHeader ) );
+	if ( Header.Magic != Magic
+		|| Header.Version != BYGCompiledFormat::Version
+		|| Header.SourceSize != Source.Size )
+	{
+		return false;
+	}
+	// Staging and source control don't keep modification times, so only then is the CSV read to check its contents.
+	// Hashing is still far cheaper than parsing
+	if ( Header.SourceTimestamp != Source.Timestamp
+		&& ( !FBYGUpdateManifest::HashFile( FullPath, Source.Hash ) || Source.Hash != Header.SourceHash ) )
+	{
+		return false;
+	}
+
+	// Guard against truncated files before we touch the index or blob
+	if ( (int64)Header.IndexOffset + (int64)Header.NumEntries * sizeof( FIndexEntry ) > DataSize
+		|| (int64)Header.BlobOffset + (int64)Header.BlobLength * sizeof( UTF16CHAR ) > DataSize
+		|| Header.IndexOffset % alignof( FIndexEntry ) != 0
+		|| Header.BlobOffset % alignof( UTF16CHAR ) != 0 )
+	{
+		UE_LOG( LogBYGLocalization, Warning, TEXT( "Compiled localization '%s' is corrupt, falling back to CSV" ), *CompiledPath );
+		return false;
+	}
+
+	const FIndexEntry* Index = reinterpret_cast<const FIndexEntry*>( Data + Header.IndexOffset );
+	const UTF16CHAR* Blob = reinterpret_cast<const UTF16CHAR*>( Data + Header.BlobOffset );
+	// Checked before adding anything, the CSV is loaded into the same table if this fails
+	for ( uint32 i = 0; i < Header.NumEntries; ++i )
+	{
+		const FIndexEntry& Entry = Index[ i ];
+		if ( (uint64)Entry.KeyOffset + Entry.KeyLength > Header.BlobLength
+			|| (uint64)Entry.ValueOffset + Entry.ValueLength > Header.BlobLength )
+		{
+			UE_LOG( LogBYGLocalization, Warning, TEXT( "Compiled localization '%s' is corrupt, falling back to CSV" ), *CompiledPath );
+			return false;
+		}
+	}
+	for ( uint32 i = 0; i < Header.NumEntries; ++i )
+	{
+		const FIndexEntry& Entry = Index[ i ];
+		Table->SetSourceString( ToString( Blob, Entry.KeyOffset, Entry.KeyLength ), ToString( Blob, Entry.ValueOffset, Entry.ValueLength ) );
+	}
+
+	return true;
+}
+
+bool FBYGStringTableLoader::WriteCompiled( const FString& FullPath, const FKeyValueArray& Pairs, const FSourceFile& Source )
+{
+	using namespace BYGCompiledFormat;
+
+	BYG_SCOPE_CYCLE_COUNTER( WriteCompiled );
+
+	FHeader Header;
+	Header.Magic = Magic;
+	Header.Version = BYGCompiledFormat::Version;
+	Header.SourceSize = Source.Size;
+	Header.SourceTimestamp = Source.Timestamp;
+	Header.SourceHash = Source.Hash;
+
+	TArray<UTF16CHAR> Blob;
+	TArray<FIndexEntry> Index;
+	Index.Reserve( Pairs.Num() );
+
+	auto AppendToBlob = [&Blob]( const FString& Str, uint32& OutOffset, uint32& OutLength )
+	{
+		FTCHARToUTF16 Converted( *Str, Str.Len() );
+		OutOffset = Blob.Num();
+		OutLength = Converted.Length();
+		Blob.Append( reinterpret_cast<const UTF16CHAR*>( Converted.Get() ), Converted.Length() );
+	};
+
+	for ( const TPair<FString, FString>& Pair : Pairs )
+	{
+		FIndexEntry& Entry = Index.AddDefaulted_GetRef();
+		AppendToBlob( Pair.Key, Entry.KeyOffset, Entry.KeyLength );
+		AppendToBlob( Pair.Value, Entry.ValueOffset, Entry.ValueLength );
+	}
+
+	Header.NumEntries = Index.Num();
+	Header.IndexOffset = sizeof( FHeader );
+	Header.BlobOffset = Header.IndexOffset + Index.Num() * sizeof( FIndexEntry );
+	Header.BlobLength = Blob.Num();
+
+	TArray<uint8> FileData;
+	FileData.Reserve( Header.BlobOffset + Blob.Num() * sizeof( UTF16CHAR ) );
+	FileData.Append( reinterpret_cast<const uint8*>( &Header ), sizeof( FHeader ) );
+	FileData.Append( reinterpret_cast<const uint8*>( Index.GetData() ), Index.Num() * sizeof( FIndexEntry ) );
+	FileData.Append( reinterpret_cast<const uint8*>( Blob.GetData() ), Blob.Num() * sizeof( UTF16CHAR ) );
+
+	if ( !FFileHelper::SaveArrayToFile( FileData, *GetCompiledPath( FullPath ) ) )
+		return false;
+
+	BYG_INC_BYTES_COUNTER( BytesWritten, FileData.Num() );
+	return true;
+}
@@ -0,0 +1,144 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Internationalization/StringTableCoreFwd.h"
+
+// Builds string tables from localization files.
+// CSV files can be compiled into a binary file that sits next to them, e.g. loc_fr.csv.bygloc. The compiled file has a header, an
+// index of entries in file order, and one contiguous UTF-16 blob holding every key and display string, so loading
+// it is a memory-map and a walk over the index with no text tokenizing.
+// The cook compiles every localization file so the compiled files are staged with the CSVs. The editor also
+// compiles a CSV the first time it loads it, packaged builds never write them.
+// A compiled file whose CSV has the same size and modification time is used as-is. If the modification time
+// changed, e.g. because the file was staged, it is still used if the CSV's contents hash the same. Otherwise we
+// fall back to parsing the CSV.
+class BYGLOCALIZATION_API FBYGStringTableLoader
+{
+public:
+	static const TCHAR* CompiledExtension;
+
+	// Safe to call from any thread. Returns null if neither a compiled nor a CSV file could be loaded
+	static FStringTablePtr BuildStringTable( const FString& Path, const FString& Namespace, bool bUseCompiled );
+
+	// Builds and registers a string table, replacing any table already registered with that ID. Must be called on
+	// the game thread. Like FStringTableRegistry::Internal_LocTableFromFile, an empty table is registered if loading fails.
+	// Any async load for the same ID that is still in flight is dropped, as if it had been superseded
+	static bool RegisterStringTable( const FName TableID, const FString& Path, const FString& Namespace, bool bUseCompiled );
+	// Must be called on the game thread. Also drops any async load for the ID that is still in flight
+	static void UnregisterStringTable( const FName TableID );
+
+	// Builds the table on the thread pool and registers it on the game thread, replacing any table already
+	// registered with that ID. The old table is unregistered and the new one registered in the same game thread
+	// task, so game thread lookups never see a missing table.
+	// OnComplete is called on the game thread. If another load for the same ID is started before this one
+	// finishes, this one is dropped and OnComplete gets false
+	static void RegisterStringTableAsync( const FName TableID, const FString& Path, const FString& Namespace, bool bUseCompiled, TFunction<void( bool )> OnComplete );
+
+	// Starts building a table on the thread pool without registering it. The next RegisterStringTableAsync for the
+	// same file picks it up instead of loading the file again. Only the latest MaxPreloads preloads are kept.
+	// Must be called on the game thread
+	static void PreloadStringTable( const FString& Path, const FString& Namespace, bool bUseCompiled );
+	static const int32 MaxPreloads;
+
+	// Rows that differ between a registered string table and a new version of its file
+	struct FTablePatch
+	{
+		// Rows that are new or whose display string changed
+		TArray<TPair<FString, FString>> Changed;
+		TArray<FString> Removed;
+
+		bool IsEmpty() const { return Changed.Num() == 0 && Removed.Num() == 0; }
+	};
+
+	// Re-reads a changed localization file on the thread pool and patches only the rows that changed into every
+	// table registered from it, instead of rebuilding them. Must be called on the game thread.
+	// Tables that are replaced or unregistered before the patch is ready are left alone
+	static void PatchStringTablesAsync( const FString& Path );
+
+	// Safe to call from any thread, string tables lock themselves. Later rows win if Pairs has duplicate keys
+	static void ComputePatch( const FStringTable& Table, const TArray<TPair<FString, FString>>& Pairs, FTablePatch& OutPatch );
+	// Must be called on the game thread
+	static void ApplyPatch( FStringTableRef Table, const FTablePatch& Patch );
+
+	// Memory used by a registered string table. Keys and strings are exact, the index is an estimate because the
+	// engine's entry and map types are opaque
+	struct FTableMemory
+	{
+		FName TableID;
+		// Full path of the file it was loaded from
+		FString Path;
+		int32 NumKeys = 0;
+		SIZE_T KeyBytes = 0;
+		// Source strings plus the display string copy each entry keeps
+		SIZE_T StringBytes = 0;
+		// Entries and the table's key map
+		SIZE_T IndexBytes = 0;
+
+		SIZE_T GetTotalBytes() const { return KeyBytes + StringBytes + IndexBytes; }
+	};
+
+	// Every table registered by us, in the order they were registered. Must be called on the game thread
+	static void GetTableMemory( TArray<FTableMemory>& OutTables );
+	static bool GetTableMemory( const FName TableID, FTableMemory& OutTable );
+
+	// Changes every time we register or unregister a table, so anything holding on to our tables knows to find them again
+	static uint32 GetTableGeneration() { return TableGeneration; }
+
+	// Relative paths are relative to the project content directory
+	static FString GetFullPath( const FString& Path );
+	static FString GetCompiledPath( const FString& FullPath );
+
+	// Writes the compiled version of a CSV file. Returns false if the CSV could not be read or the file couldn't be written
+	static bool Compile( const FString& FullPath );
+	// Compiles every file in Paths, logging any that fail. Returns the number compiled
+	static int32 CompileAll( const TArray<FString>& Paths );
+
+protected:
+	typedef TArray<TPair<FString, FString>> FKeyValueArray;
+
+	// The CSV a compiled file was built from
+	struct FSourceFile
+	{
+		int64 Size = 0;
+		int64 Timestamp = 0;
+		uint64 Hash = 0;
+	};
+
+	// OutHash is the hash of the whole file, same as FBYGUpdateManifest::HashFile would give
+	static bool ParseCSV( const FString& FullPath, FKeyValueArray& OutPairs, uint64* OutHash = nullptr );
+	static bool GetSourceFile( const FString& FullPath, FSourceFile& OutSource );
+	static bool LoadCompiled( const FString& FullPath, FStringTableRef Table );
+	static bool WriteCompiled( const FString& FullPath, const FKeyValueArray& Pairs, const FSourceFile& Source );
+
+	// Game thread only. Unregisters any table with the ID and registers the new one, the registry won't register
+	// over an existing ID
+	static void ReplaceStringTable( const FName TableID, FStringTableRef Table, const FString& FullPath );
+	// Finishes a RegisterStringTableAsync request once its table is built. Game thread only
+	static void CompleteAsyncRequest( const FName TableID, const FString& Path, uint32 RequestID, FStringTablePtr Table, const TFunction<void( bool )>& OnComplete );
+
+	static uint32 TableGeneration;
+
+	// Full path of the file each registered table was loaded from, so file changes can be matched to tables.
+	// Game thread only
+	static TMap<FName, FString> LoadedTablePaths;
+
+	struct FPreload
+	{
+		FString Namespace;
+		bool bUseCompiled = false;
+		TFuture<FStringTablePtr> Table;
+		// Preloads past MaxPreloads are dropped oldest first
+		uint32 RequestID = 0;
+	};
+	// Keyed by full path. Game thread only
+	static TMap<FString, FPreload> Preloads;
+	// Latest async request for each table ID, so older requests that finish late don't replace newer ones
+	static TMap<FName, uint32> LatestAsyncRequests;
+	static uint32 AsyncRequestCounter;
+
+	friend class FBYGCompiledLocalizationTest;
+	friend class FBYGStringTableAsyncTest;
+};
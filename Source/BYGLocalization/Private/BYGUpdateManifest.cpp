@@ -0,0 +1,181 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#include "BYGUpdateManifest.h"
+#include "BYGLocalizationCoreMinimal.h"
+#include "BYGLocalizationSettings.h"
+
+#include "Dom/JsonObject.h"
+#include "Hash/CityHash.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+namespace BYGUpdateManifest
+{
+	// Increase this if anything about how files are merged or written changes, so old manifests are ignored
+	static const int32 Version = 2;
+
+	static FString HashToString( uint64 Hash )
+	{
+		return FString::Printf( TEXT( "%016llx" ), Hash );
+	}
+
+	static FString GetStatePath( const FString& PrimaryPath, const TCHAR* Extension )
+	{
+		const uint32 PathHash = FCrc::StrCrc32( *FPaths::ConvertRelativePathToFull( PrimaryPath ).ToLower() );
+		return FPaths::Combine( FPaths::ProjectSavedDir(), TEXT( "BYGLocalization" ), FString::Printf( TEXT( "Update_%08x.%s" ), PathHash, Extension ) );
+	}
+
+	static uint64 HashFromString( const FString& Str )
+	{
+		return FCString::Strtoui64( *Str, nullptr, 16 );
+	}
+
+	// Sizes and timestamps are strings for the same reason as hashes, JSON numbers are doubles
+	static TSharedRef<FJsonObject> FileToJson( const FBYGUpdateManifest::FFile& File )
+	{
+		TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+		Json->SetStringField( TEXT( "Size" ), LexToString( File.Size ) );
+		Json->SetStringField( TEXT( "Timestamp" ), LexToString( File.Timestamp.GetTicks() ) );
+		Json->SetStringField( TEXT( "Hash" ), HashToString( File.Hash ) );
+		return Json;
+	}
+
+	static bool FileFromJson( const TSharedPtr<FJsonValue>& Value, FBYGUpdateManifest::FFile& OutFile )
+	{
+		const TSharedPtr<FJsonObject>* Json = nullptr;
+		if ( !Value.IsValid() || !Value->TryGetObject( Json ) )
+			return false;
+		OutFile.Size = FCString::Atoi64( *( *Json )->GetStringField( TEXT( "Size" ) ) );
+		OutFile.Timestamp = FDateTime( FCString::Atoi64( *( *Json )->GetStringField( TEXT( "Timestamp" ) ) ) );
+		OutFile.Hash = HashFromString( ( *Json )->GetStringField( TEXT( "Hash" ) ) );
+		return true;
+	}
+}
+
+bool FBYGUpdateManifest::Load( const FString& Path )
+{
+	Primary = FFile();
+	SettingsHash = 0;
+	Files.Empty();
+
+	FString JsonString;
+	if ( !FFileHelper::LoadFileToString( JsonString, *Path, FFileHelper::EHashOptions::None, FILEREAD_Silent ) )
+		return false;
+
+	TSharedPtr<FJsonObject> Root;
+	if ( !FJsonSerializer::Deserialize( TJsonReaderFactory<>::Create( JsonString ), Root ) || !Root.IsValid() )
+	{
+		UE_LOG( LogBYGLocalization, Warning, TEXT( "Could not read update manifest '%s', all files will be updated" ), *Path );
+		return false;
+	}
+
+	if ( Root->GetIntegerField( TEXT( "Version" ) ) != BYGUpdateManifest::Version )
+		return false;
+
+	BYGUpdateManifest::FileFromJson( Root->TryGetField( TEXT( "Primary" ) ), Primary );
+	SettingsHash = BYGUpdateManifest::HashFromString( Root->GetStringField( TEXT( "SettingsHash" ) ) );
+
+	const TSharedPtr<FJsonObject>* FilesJson = nullptr;
+	if ( Root->TryGetObjectField( TEXT( "Files" ), FilesJson ) )
+	{
+		for ( const TPair<FString, TSharedPtr<FJsonValue>>& Pair : ( *FilesJson )->Values )
+		{
+			FFile File;
+			if ( BYGUpdateManifest::FileFromJson( Pair.Value, File ) )
+			{
+				Files.Add( Pair.Key, File );
+			}
+		}
+	}
+
+	return true;
+}
+
+bool FBYGUpdateManifest::Save( const FString& Path ) const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField( TEXT( "Version" ), BYGUpdateManifest::Version );
+	Root->SetObjectField( TEXT( "Primary" ), BYGUpdateManifest::FileToJson( Primary ) );
+	Root->SetStringField( TEXT( "SettingsHash" ), BYGUpdateManifest::HashToString( SettingsHash ) );
+
+	TSharedRef<FJsonObject> FilesJson = MakeShared<FJsonObject>();
+	for ( const TPair<FString, FFile>& Pair : Files )
+	{
+		FilesJson->SetObjectField( Pair.Key, BYGUpdateManifest::FileToJson( Pair.Value ) );
+	}
+	Root->SetObjectField( TEXT( "Files" ), FilesJson );
+
+	FString JsonString;
+	if ( !FJsonSerializer::Serialize( Root, TJsonWriterFactory<>::Create( &JsonString ) ) )
+		return false;
+
+	return FFileHelper::SaveStringToFile( JsonString, *Path );
+}
+
+FString FBYGUpdateManifest::GetManifestPath( const FString& PrimaryPath )
+{
+	return BYGUpdateManifest::GetStatePath( PrimaryPath, TEXT( "manifest" ) );
+}
+
+FString FBYGUpdateManifest::GetSnapshotPath( const FString& PrimaryPath )
+{
+	return BYGUpdateManifest::GetStatePath( PrimaryPath, TEXT( "snapshot" ) );
+}
+
+bool FBYGUpdateManifest::HashFile( const FString& Path, uint64& OutHash )
+{
+	TArray<uint8> Data;
+	if ( !FFileHelper::LoadFileToArray( Data, *Path, FILEREAD_Silent ) )
+		return false;
+
+	BYG_INC_BYTES_COUNTER( BytesRead, Data.Num() );
+	OutHash = CityHash64( reinterpret_cast<const char*>( Data.GetData() ), Data.Num() );
+	return true;
+}
+
+bool FBYGUpdateManifest::StatFile( const FString& Path, FFile& OutFile )
+{
+	OutFile = FFile();
+	const FFileStatData StatData = IFileManager::Get().GetStatData( *Path );
+	if ( !StatData.bIsValid || StatData.bIsDirectory )
+		return false;
+
+	OutFile.Size = StatData.FileSize;
+	OutFile.Timestamp = StatData.ModificationTime;
+	return true;
+}
+
+bool FBYGUpdateManifest::IsUnchanged( const FString& Path, const FFile* Last, FFile& OutFile )
+{
+	if ( !StatFile( Path, OutFile ) || !Last || OutFile.Size != Last->Size )
+		return false;
+
+	if ( OutFile.Timestamp == Last->Timestamp )
+	{
+		OutFile.Hash = Last->Hash;
+		return true;
+	}
+
+	// Touched, checked out or copied, but maybe not changed
+	return HashFile( Path, OutFile.Hash ) && OutFile.Hash == Last->Hash;
+}
+
+uint64 FBYGUpdateManifest::HashSettings( const UBYGLocalizationSettings& Settings )
+{
+	// Everything that changes the bytes UpdateTranslationFile would write
+	const FString Combined = FString::Printf( TEXT( "%s|%d|%d|%d|%s|%s|%s|%s" ),
+		*Settings.PrimaryLanguageCode,
+		static_cast<int32>( Settings.QuotingPolicy ),
+		static_cast<int32>( Settings.FileEncoding ),
+		Settings.bPreserveDeprecatedLines ? 1 : 0,
+		*Settings.NewStatus,
+		*Settings.ModifiedStatusLeft,
+		*Settings.ModifiedStatusRight,
+		*Settings.DeprecatedStatus );
+
+	return CityHash64( reinterpret_cast<const char*>( *Combined ), Combined.Len() * sizeof( TCHAR ) );
+}
@@ -0,0 +1,52 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UBYGLocalizationSettings;
+
+// Records what the inputs to the last UpdateTranslations run looked like, so files whose inputs have not
+// changed since can be skipped entirely.
+// Stored as JSON in Saved/BYGLocalization, not next to the localization files, so it is never staged with them or
+// checked in. Hashes are stored as hex strings because JSON numbers can't hold a full 64-bit value.
+class FBYGUpdateManifest
+{
+public:
+	// Named after the primary file's full path, so each localization directory gets its own manifest
+	static FString GetManifestPath( const FString& PrimaryPath );
+	// Copy of the primary file that Primary was taken from, used to work out what changed since
+	static FString GetSnapshotPath( const FString& PrimaryPath );
+
+	// A file as it was when we last read or wrote it. The size and modification time let unchanged files be
+	// recognised without reading them
+	struct FFile
+	{
+		int64 Size = 0;
+		FDateTime Timestamp;
+		uint64 Hash = 0;
+
+		bool operator==( const FFile& Other ) const { return Size == Other.Size && Timestamp == Other.Timestamp && Hash == Other.Hash; }
+		bool operator!=( const FFile& Other ) const { return !( *this == Other ); }
+	};
+
+	// Returns false if there is no manifest or it could not be read, in which case the manifest is left empty
+	bool Load( const FString& Path );
+	bool Save( const FString& Path ) const;
+
+	// The primary file that every locale file was last merged against
+	FFile Primary;
+	// Hash of the settings that change what gets written, e.g. quoting policy and status strings
+	uint64 SettingsHash = 0;
+	// Each locale file as we last wrote it, keyed by the path relative to the content directory
+	TMap<FString, FFile> Files;
+
+	static bool HashFile( const FString& Path, uint64& OutHash );
+	// Size and modification time only, the hash is left at 0
+	static bool StatFile( const FString& Path, FFile& OutFile );
+	// Fills in the size and modification time of the file on disk, and returns true if it has the same contents as
+	// Last. Last may be null. A file whose size changed is never read, one whose size and modification time both
+	// match is trusted, and only otherwise is it hashed. OutFile's hash is left at 0 if the file wasn't hashed
+	static bool IsUnchanged( const FString& Path, const FFile* Last, FFile& OutFile );
+	static uint64 HashSettings( const UBYGLocalizationSettings& Settings );
+};
@@ -0,0 +1,47 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StringView.h"
+
+struct FBYGLocaleData;
+
+// Flat open-addressing index from localization key to entry index.
+// Each slot holds the precomputed 64-bit hash of the key and the index of the entry, the key itself is only
+// compared for slots whose hash matches. Slots live in one array, at most half full, so a lookup is usually a
+// single probe with no pointer chasing.
+// Keys are case-insensitive, same as the TMap<FString, int32> this replaces.
+class BYGLOCALIZATION_API FBYGKeyIndex
+{
+public:
+	// Entries whose key matches an earlier entry are left out of the index, and their indices added to OutDuplicates
+	void Build( const FBYGLocaleData& Data, TArray<int32>& OutDuplicates );
+	void Reset();
+
+	// Data must be what the index was built from. Returns INDEX_NONE if the key is not found
+	int32 Find( const FBYGLocaleData& Data, const FStringView& Key ) const
+	{
+		return Find( Data, Key, HashKey( Key ) );
+	}
+	int32 Find( const FBYGLocaleData& Data, const FStringView& Key, uint64 KeyHash ) const;
+
+	int32 Num() const { return NumKeys; }
+	SIZE_T GetAllocatedSize() const { return Slots.GetAllocatedSize(); }
+
+	static uint64 HashKey( const FStringView& Key );
+
+protected:
+	struct FSlot
+	{
+		uint64 Hash = 0;
+		int32 Index = INDEX_NONE;
+	};
+
+	// Returns the slot holding the key, or the empty slot where it would go
+	int32 FindSlot( const FBYGLocaleData& Data, const FStringView& Key, uint64 KeyHash ) const;
+
+	TArray<FSlot> Slots;
+	uint32 SlotMask = 0;
+	int32 NumKeys = 0;
+};
@@ -3,9 +3,14 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeBool.h"
 #include "Internationalization/Culture.h"
+#include "BYGKeyIndex.h"
 #include "BYGLocalizationSettings.h"
 
+class FBYGStatusMatcher;
+
 enum class EBYGLocEntryStatus : uint8
 {
 	None,
@@ -44,19 +49,202 @@ struct FBYGLocalizationEntry
 	EBYGLocEntryStatus Status = EBYGLocEntryStatus::None;
 };
 
-// Internal data structure for 
-struct FBYGLocaleData
+// Internal data structure for the entries of a localization file, in file order.
+// All of the text lives in one buffer and each column is an array of offset/length spans into it, so a file
+// costs a handful of allocations however many rows it has. A parsed file keeps the buffer it was read into
+// and its spans point straight at the cells.
+// Entries can't be changed once added, build a new FBYGLocaleData instead
+struct BYGLOCALIZATION_API FBYGLocaleData
 {
 public:
 	FBYGLocaleData() {}
+	// Copies the text of the entries and builds the key index
 	FBYGLocaleData( const TArray<FBYGLocalizationEntry>& NewEntries );
+	// Takes over a buffer. Views into it passed to AddEntry are kept as spans instead of being copied
+	explicit FBYGLocaleData( FString&& InText );
+
+	void Reserve( int32 NumEntries, int32 NumChars );
+	// Views that don't point into our text are copied onto the end of it. Returns the index of the entry
+	int32 AddEntry( const FStringView& Key, const FStringView& Translation, const FStringView& Comment, const FStringView& Primary, const FStringView& OldPrimary, EBYGLocEntryStatus Status );
+	// Copies an entry from other data, optionally with a different status
+	int32 AddEntry( const FBYGLocaleData& Other, int32 Index ) { return AddEntry( Other, Index, Other.GetStatus( Index ) ); }
+	int32 AddEntry( const FBYGLocaleData& Other, int32 Index, EBYGLocEntryStatus Status );
+	// Builds the key index and logs any duplicate keys. Call once every entry has been added
+	void BuildIndex();
+
+	inline int32 Num() const { return Statuses.Num(); }
+	inline FStringView GetKey( int32 Index ) const { return GetField( EField::Key, Index ); }
+	inline FStringView GetTranslation( int32 Index ) const { return GetField( EField::Translation, Index ); }
+	inline FStringView GetComment( int32 Index ) const { return GetField( EField::Comment, Index ); }
+	inline FStringView GetPrimary( int32 Index ) const { return GetField( EField::Primary, Index ); }
+	inline FStringView GetOldPrimary( int32 Index ) const { return GetField( EField::OldPrimary, Index ); }
+	inline EBYGLocEntryStatus GetStatus( int32 Index ) const { return Statuses[ Index ]; }
+	// Copies an entry out into its own strings
+	FBYGLocalizationEntry GetEntry( int32 Index ) const;
+
+	// Returns INDEX_NONE if there is no entry with that key. Keys are case-insensitive
+	inline int32 FindIndex( const FStringView& InKey ) const { return KeyIndex.Find( *this, InKey ); }
+	inline bool Contains( const FStringView& InKey ) const { return FindIndex( InKey ) != INDEX_NONE; }
+	// Indices of entries whose key was already used by an earlier entry. These can't be looked up by key
+	inline const TArray<int32>& GetDuplicateIndices() const { return DuplicateIndices; }
+	inline bool HasDuplicateKeys() const { return DuplicateIndices.Num() > 0; }
+
+	// Total length of every field of every entry
+	inline int32 GetNumChars() const { return NumChars; }
+	// Heap memory of the text, the spans and the key index
+	SIZE_T GetAllocatedSize() const;
+
+protected:
+	enum class EField : uint8
+	{
+		Key,
+		Translation,
+		Comment,
+		Primary,
+		OldPrimary,
+		Num
+	};
+	static constexpr int32 NumFields = static_cast<int32>( EField::Num );
+
+	struct FSpan
+	{
+		int32 Offset = 0;
+		int32 Len = 0;
+	};
+
+	inline FStringView GetField( EField Field, int32 Index ) const
+	{
+		const FSpan& Span = Spans[ static_cast<int32>( Field ) ][ Index ];
+		return FStringView( Text.GetCharArray().GetData() + Span.Offset, Span.Len );
+	}
+
+	FString Text;
+	// One array per column, indexed by entry
+	TArray<FSpan> Spans[ NumFields ];
+	TArray<EBYGLocEntryStatus> Statuses;
+	int32 NumChars = 0;
+	FBYGKeyIndex KeyIndex;
+	TArray<int32> DuplicateIndices;
+
+	// Parses files in place in Text
+	friend class UBYGLocalization;
+};
+
+// Fixed-size count of entries per status, indexed by EBYGLocEntryStatus
+struct FBYGLocStatCounts
+{
+	static constexpr int32 NumStatuses = 4;
+
+	int32& operator[]( EBYGLocEntryStatus Status ) { return Counts[ static_cast<uint8>( Status ) ]; }
+	int32 operator[]( EBYGLocEntryStatus Status ) const { return Counts[ static_cast<uint8>( Status ) ]; }
+
+	int32 Counts[ NumStatuses ] = { 0, 0, 0, 0 };
+};
+
+typedef FBYGLocStatCounts BYGLocStats;
+
+// Outcome of updating a single localization file. Warnings are collected rather than logged straight away so
+// that files can be updated in parallel and still produce the same log
+struct BYGLOCALIZATION_API FBYGUpdateFileResult
+{
+	FString Path;
+	// Language code from the filename
+	FString Culture;
+	// Problems with the file itself. Keys the merge changed are in ChangedKeys
+	TArray<FString> Warnings;
+	// Keys that were added, modified or deprecated, indexed by their new EBYGLocEntryStatus and in file order
+	TArray<FString> ChangedKeys[ FBYGLocStatCounts::NumStatuses ];
+	// One line per changed key with the old and new text. Only filled in when LogBYGLocalization is Verbose
+	TArray<FString> VerboseMessages;
+	double Seconds = 0.0;
+	// Hash of the file contents after updating, same as FBYGUpdateManifest::HashFile would give
+	uint64 Hash = 0;
+	// The file was merged successfully
+	bool bUpdated = false;
+	// The merged file was different to what was on disk and had to be written
+	bool bWritten = false;
+
+	const TArray<FString>& GetChangedKeys( EBYGLocEntryStatus Status ) const { return ChangedKeys[ static_cast<uint8>( Status ) ]; }
+	void AddChangedKey( EBYGLocEntryStatus Status, const FStringView& Key ) { ChangedKeys[ static_cast<uint8>( Status ) ].Emplace( Key.Len(), Key.GetData() ); }
+	int32 GetNumChangedKeys() const;
+
+	// Logs the warnings and a one line summary of the changed keys, plus one line per key at Verbose
+	void Flush() const;
+};
+
+// Every locale file merged by an UpdateTranslations call and the keys that changed in each
+struct BYGLOCALIZATION_API FBYGUpdateReport
+{
+	TArray<FBYGUpdateFileResult> Files;
+
+	// Saved/BYGLocalization/UpdateReport.json or .csv
+	static FString GetDefaultPath( EBYGUpdateReportFormat Format );
+	bool Save( const FString& Path, EBYGUpdateReportFormat Format ) const;
+
+protected:
+	// One object per file with its counts per status and the changed keys
+	bool SaveJson( const FString& Path ) const;
+	// One row per changed key: Locale,Path,Status,Key
+	bool SaveCSV( const FString& Path ) const;
+};
+
+// Differences between the primary file as it was when locale files were last written and as it is now.
+// Computed once per update and applied to every locale file that hasn't changed since we last wrote it.
+struct FBYGPrimaryDelta
+{
+	int32 NumOldEntries = 0;
+	// For each entry in the new primary, the index of the same key in the old primary, or INDEX_NONE if it was added
+	TArray<int32> NewToOld;
+	// Indices into the new primary
+	TArray<int32> Added;
+	// Indices into the new primary of keys whose primary text changed
+	TArray<int32> Modified;
+	TBitArray<> bIsModified;
+	// Indices into the old primary of keys that no longer exist, in ascending order
+	TArray<int32> Removed;
+	// Same keys in the same order, so only Modified entries need to be touched
+	bool bSameKeyOrder = false;
+};
+
+// Memory held by the parsed files and merged entries during an UpdateTranslations call. Strings are counted by
+// their allocated size, allocator overhead is not included
+struct FBYGUpdateMemoryReport
+{
+	// Locale files that were merged
+	int32 NumFiles = 0;
+	// The parsed primary file and the primary delta, held for the whole update
+	int64 PrimaryBytes = 0;
+	// Most bytes held at once, including every locale file being merged at the same time
+	int64 PeakBytes = 0;
+};
 
-	inline const TArray<FBYGLocalizationEntry>* GetEntriesInOrder() const { return &EntriesInOrder; }
-	inline const TMap<FString, int32>* GetKeyToIndex() const { return &KeyToIndex; }
+// Running total of bytes held across threads that remembers the highest it reached
+class FBYGMemoryHighWater
+{
+public:
+	void Reset()
+	{
+		FPlatformAtomics::InterlockedExchange( &Current, 0 );
+		FPlatformAtomics::InterlockedExchange( &Peak, 0 );
+	}
+	void Add( int64 Bytes )
+	{
+		const int64 NewCurrent = FPlatformAtomics::InterlockedAdd( &Current, Bytes ) + Bytes;
+		int64 OldPeak = FPlatformAtomics::AtomicRead( &Peak );
+		while ( NewCurrent > OldPeak )
+		{
+			const int64 Previous = FPlatformAtomics::InterlockedCompareExchange( &Peak, NewCurrent, OldPeak );
+			if ( Previous == OldPeak )
+				break;
+			OldPeak = Previous;
+		}
+	}
+	void Remove( int64 Bytes ) { FPlatformAtomics::InterlockedAdd( &Current, -Bytes ); }
+	int64 GetPeak() const { return FPlatformAtomics::AtomicRead( &Peak ); }
 
 protected:
-	TArray<FBYGLocalizationEntry> EntriesInOrder;
-	TMap<FString, int32> KeyToIndex;
+	volatile int64 Current = 0;
+	volatile int64 Peak = 0;
 };
 
 class IBYGLocalizationSettingsProvider
@@ -75,8 +263,6 @@ public:
 	}
 };
 
-typedef TMap<EBYGLocEntryStatus, int32> BYGLocStats;
-
 // Internal data structure used for	updating non-primary localizations based on the information in the primary
 // We re-order entries in the non-primary to match those of the 
 class BYGLOCALIZATION_API UBYGLocalization
@@ -90,8 +276,14 @@ public:
 
 	// Returns false when no primary translations found
 	bool UpdateTranslations();
+	// Memory used by the last UpdateTranslations call
+	const FBYGUpdateMemoryReport& GetLastUpdateMemory() const { return LastUpdateMemory; }
+	// Every locale file the last UpdateTranslations call merged and the keys that changed in it
+	const FBYGUpdateReport& GetLastUpdateReport() const { return LastUpdateReport; }
 
-	bool GetLocalizationStats( const FString& Filename, BYGLocStats& StatusCounts ) const;
+	// Only looks at the Status column, no strings are created for the other columns.
+	// Safe to call from worker threads. Stops early and returns false if bCancelled is set
+	bool GetLocalizationStats( const FString& Filename, BYGLocStats& StatusCounts, const FThreadSafeBool* bCancelled = nullptr ) const;
 
 	bool GetLocaleFromPreferences( FBYGLocaleInfo& FoundLocale ) const;
 
@@ -103,16 +295,61 @@ public:
 	FString GetFileWithPathFromLanguageCode( const FString& LanguageCode ) const;
 
 	bool GetAuthorForLocale( const FString& Filename, FText& Author ) const;
+
+	// Full paths of every directory that is searched for localization files
+	TArray<FString> GetLocalizationDirectories() const;
+	// True if the filename has the prefix, suffix and one of the extensions from settings
+	bool IsLocalizationFile( const FString& Filename ) const;
+
+	typedef TSharedRef<const TArray<FString>, ESPMode::ThreadSafe> FFileListRef;
+	// Every localization file in the localization directories, relative to the content directory.
+	// The directories are only scanned the first time, after InvalidateLocalizationFiles or when the discovery
+	// settings change. The list is never modified, so it is safe to keep and read from any thread
+	FFileListRef GetLocalizationFilesSnapshot() const;
+	// Call when files may have been added to or removed from the localization directories
+	void InvalidateLocalizationFiles();
 protected:
 	// We have a settings provider to allow for easier testing. In production we use GetDefault<UBYGLocalizationSettings>().
 	TSharedPtr<const IBYGLocalizationSettingsProvider> SettingsProvider;
 
-	bool GetLocalizationDataFromFile( const FString& Filename, FBYGLocaleData& LocalizationData ) const;
-	bool UpdateTranslationFile( const FString& Path, const TArray<FBYGLocalizationEntry>* PrimaryEntriesInOrder, const TMap<FString, int32>* PrimaryKeyToIndex );
+	mutable FCriticalSection DiscoveredFilesCS;
+	mutable TSharedPtr<const TArray<FString>, ESPMode::ThreadSafe> DiscoveredFiles;
+	mutable FString DiscoveredFilesSettingsKey;
+
+	FBYGUpdateReport LastUpdateReport;
+	FBYGUpdateMemoryReport LastUpdateMemory;
+	// Bytes held by the update in progress, from every thread
+	FBYGMemoryHighWater UpdateMemory;
+
+	// OutHash is the hash of the file as it was read, same as FBYGUpdateManifest::HashFile
+	bool GetLocalizationDataFromFile( const FString& Filename, FBYGLocaleData& LocalizationData, uint64* OutHash = nullptr ) const;
+	// GetLocalizationStats with the statuses already matched up. Doesn't need an instance, so it's safe for work that
+	// may outlive us. OutHash is the hash of the file as it was scanned, same as FBYGUpdateManifest::HashFile
+	static bool GetLocalizationStats( const FString& Filename, const FBYGStatusMatcher& StatusMatcher, BYGLocStats& StatusCounts, const FThreadSafeBool* bCancelled, uint64* OutHash = nullptr );
+	// Safe to call from worker threads. If OutResult is null, warnings are logged before returning.
+	// Delta must only be passed if the file at Path is unchanged since it was last written against the old primary
+	bool UpdateTranslationFile( const FString& Path, const FBYGLocaleData& PrimaryData, FBYGUpdateFileResult* OutResult = nullptr, const FBYGPrimaryDelta* Delta = nullptr );
+
+	// Returns false if the two can't be diffed, e.g. because of duplicate keys
+	static bool ComputePrimaryDelta( const FBYGLocaleData& OldPrimary, const FBYGLocaleData& NewPrimary, FBYGPrimaryDelta& OutDelta );
+	// Adds the merge of a primary entry and the locale's entry for the same key to OutData. LocalIndex is INDEX_NONE if the locale doesn't have the key
+	static void MergeEntry( const FBYGLocaleData& PrimaryData, int32 PrimaryIndex, const FBYGLocaleData& LocalData, int32 LocalIndex, const FString& CultureName, FBYGUpdateFileResult& Result, FBYGLocaleData& OutData );
+	static void DeprecateEntry( const FBYGLocaleData& LocalData, int32 LocalIndex, const FString& CultureName, FBYGUpdateFileResult& Result, FBYGLocaleData& OutData );
 
 	TArray<FString> GetAllLocalizationFiles() const;
+	// Scans each directory on its own thread
+	FFileListRef DiscoverLocalizationFiles() const;
+	// A DepthRemaining of INDEX_NONE means no limit
+	void FindLocalizationFiles( const FString& Directory, int32 DepthRemaining, TArray<FString>& OutFiles ) const;
+	// Everything from settings that changes which files are found
+	FString GetDiscoverySettingsKey() const;
 	// Writes datastructure to CSV but with explicit quoting etc.
-	bool WriteCSV( const TArray<FBYGLocalizationEntry>& Entries, const FString& Filename );
+	// ExistingHash is the hash of the file as it is now, e.g. from when it was loaded. The file is left untouched if
+	// that matches the new contents, bOutWritten says whether it was written. OutHash is the hash of the file contents either way
+	bool WriteCSV( const FBYGLocaleData& Data, const FString& Filename, bool* bOutWritten = nullptr, uint64* OutHash = nullptr, const uint64* ExistingHash = nullptr );
+	// Writes Bytes to Filename.tmp, flushes it and renames it over Filename in one step, so Filename always has either
+	// the old or the new contents. With bCreateBackup, the old file is hard-linked to Filename.bak first
+	static bool ReplaceFile( const FString& Filename, TArrayView<const uint8> Bytes, bool bCreateBackup );
 
 	FString RemovePrefixSuffix( const FString& FileWithExtension ) const;
 
@@ -120,11 +357,21 @@ protected:
 
 	static FString LazyWrap( const FString& InStr, bool bForceWrap = false );
 
+	friend class FBYGLocStatsJob;
+
 	// Hacky testing
 	friend class FBYGEscapeCharacterTest;
 	friend class FBYGLazyWrapTest;
 	friend class FBYGWriteCSVTest;
+	friend class FBYGReplaceFileTest;
 	friend class FBYGFullLoopTest;
+	friend class FBYGPrimaryDeltaTest;
+	friend class FBYGUpdateAllocationsTest;
+	friend class FBYGUpdateReportTest;
+	friend class FBYGFileEncodingTest;
+	friend class FBYGStatsTest;
+	friend class FBYGKeyIndexTest;
+	friend class FBYGPerfTestAccess;
 
 };
 
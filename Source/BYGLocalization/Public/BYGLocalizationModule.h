@@ -3,9 +3,14 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "Containers/Ticker.h"
 #include "Core/Public/Modules/ModuleManager.h"
 #include "UObject/GCObject.h"
 
+struct FBYGLocaleInfo;
+struct FFileChangeData;
+
 class FBYGLocalizationModule : public IModuleInterface, public FGCObject
 {
 public:
@@ -18,6 +23,17 @@ public:
 
 	void ReloadLocalizations();
 
+	// Starts loading the localization that best matches the player's OS language in the background.
+	// Returns false if none matches. Switch to it with UBYGLocalizationStatics::SetLocalizationFromFileAsync
+	bool PreloadPreferredLocalization( FBYGLocaleInfo& OutLocale );
+
+	// Call when the directories to watch or the hot reload settings change
+	void RestartWatchingFiles();
+
+	// Logs the memory used by each loaded string table and by the last UpdateTranslations.
+	// With bRunUpdate, runs UpdateTranslations first so its peak is current. Also the BYG.Localization.Memory command
+	void LogMemoryReport( bool bRunUpdate );
+
 	static inline FBYGLocalizationModule& Get()
 	{
 		static FName ModuleName( "BYGLocalization" );
@@ -31,9 +47,27 @@ public:
 protected:
 	void UnloadLocalizations();
 
+	// Watches the localization directories and patches files that change into the string tables loaded from them.
+	// Does nothing unless hot reload is enabled in settings for this kind of build
+	void StartWatchingFiles();
+	void StopWatchingFiles();
+	void OnDirectoryChanged( const TArray<FFileChangeData>& Changes );
+	// Reloads files once they've stopped changing for HotReloadDelay seconds
+	bool TickHotReload( float DeltaTime );
+
 	// TODO FGCObject
 	TSharedPtr<class UBYGLocalization> Loc;
 	TSharedPtr<class UBYGLocalizationSettingsProvider> Provider;
 
 	TArray<FName> StringTableIDs;
+
+	TArray<TPair<FString, FDelegateHandle>> WatchedDirectories;
+#if ENGINE_MAJOR_VERSION >= 5
+	FTSTicker::FDelegateHandle HotReloadTickerHandle;
+#else
+	FDelegateHandle HotReloadTickerHandle;
+#endif
+	// Full paths of files changed since the last reload
+	TSet<FString> PendingHotReloadFiles;
+	double LastFileChangeTime = 0.0;
 };
@@ -18,6 +18,26 @@ enum class EBYGQuotingPolicy : uint8
 	OnlyWhenNeeded
 };
 
+UENUM()
+enum class EBYGFileEncoding : uint8
+{
+	// No byte order mark. Identical to ASCII for files that only use ASCII characters
+	UTF8,
+	// With byte order mark. Roughly twice the size of UTF-8 for mostly-Latin text
+	UTF16
+};
+
+UENUM()
+enum class EBYGUpdateReportFormat : uint8
+{
+	// The report is only kept in memory
+	None,
+	// One object per locale file with counts per status and the changed keys
+	JSON,
+	// One row per changed key
+	CSV
+};
+
 
 UENUM()
 enum class EBYGPathRoot
@@ -92,6 +112,10 @@ public:
 	UPROPERTY( config, EditAnywhere, Category = "File Settings", AdvancedDisplay )
 	bool bIncludeSubdirectories = true;
 
+	// How many levels of subdirectories to search below each localization directory. 0 means no limit
+	UPROPERTY( config, EditAnywhere, Category = "File Settings", AdvancedDisplay, meta = ( EditCondition = "bIncludeSubdirectories", ClampMin = "0" ) )
+	int32 MaxSubdirectoryDepth = 0;
+
 	// Files that start with the prefix, followed by a language code, followed by the suffix, will be matched
 	UPROPERTY( config, EditAnywhere, Category = "File Settings" )
 	FString FilenamePrefix = "loc_";
@@ -112,10 +136,15 @@ public:
 	UPROPERTY( config, EditAnywhere, Category = "File Settings" )
 	TArray<FString> AllowedExtensions = { "txt" };
 
-	// Creates a backup of the original file when changing any localization files
+	// Keeps the previous version of a localization file as <filename>.bak when updating it
 	UPROPERTY( config, EditAnywhere, Category = "File Settings" )
 	bool bCreateBackup = true;
 
+	// When true, each CSV is compiled to a binary .bygloc file next to it by the cook, or by the editor the first time
+	// it is loaded, and the compiled file is memory-mapped instead of parsing the CSV until the CSV changes
+	UPROPERTY( config, EditAnywhere, AdvancedDisplay, Category = "File Settings" )
+	bool bUseCompiledLocalizations = true;
+
 	// If true, the CSV update process ignores if a file is marked "read-only" and will overwrite it anyway
 	UPROPERTY( config, EditAnywhere, AdvancedDisplay, Category = "File Settings" )
 	bool bAllowOverwriteReadOnlyFiles = false;
@@ -129,6 +158,10 @@ public:
 	UPROPERTY( config, EditAnywhere, Category = "CSV Content Settings" )
 	EBYGQuotingPolicy QuotingPolicy = EBYGQuotingPolicy::ForceQuoted;
 
+	// Encoding used when updating localization files
+	UPROPERTY( config, EditAnywhere, AdvancedDisplay, Category = "CSV Content Settings" )
+	EBYGFileEncoding FileEncoding = EBYGFileEncoding::UTF8;
+
 	// If a key is longer than this number of characters, show a warning. Useful for finding runaway strings
 	UPROPERTY( config, EditAnywhere, AdvancedDisplay, Category = "CSV Content Settings" )
 	int32 WarnOnLongKey = 100;
@@ -154,6 +187,20 @@ public:
 	UPROPERTY( config, EditAnywhere, Category = "Fan Translation Settings", meta = ( EditCondition = "bUpdateLocsWithCommandLineFlag" ) )
 	FString CommandLineFlag = "UpdateLocalization";
 
+	// When true, localization files are updated on worker threads at the same time. Output is identical to updating them one-by-one
+	UPROPERTY( config, EditAnywhere, AdvancedDisplay, Category = "Fan Translation Settings" )
+	bool bParallelUpdate = true;
+
+	// When true, a manifest of file hashes is kept in Saved/BYGLocalization and locale files are only
+	// updated if they, the primary file or the update settings changed since they were last written
+	UPROPERTY( config, EditAnywhere, AdvancedDisplay, Category = "Fan Translation Settings" )
+	bool bIncrementalUpdate = true;
+
+	// Each update builds a report of the keys added, modified and deprecated in every locale. Only a summary per locale is
+	// logged, set LogBYGLocalization to Verbose to log every key. The report can also be saved to Saved/BYGLocalization/
+	UPROPERTY( config, EditAnywhere, AdvancedDisplay, Category = "Fan Translation Settings" )
+	EBYGUpdateReportFormat UpdateReportFormat = EBYGUpdateReportFormat::None;
+
 	// If a key no longer exists in the primary language, any instances of it in other languages are marked "deprecated" in others.
 	// If true, all deprecated lines are kept in secondary localizations and marked. If false, they are deleted.
 	UPROPERTY( config, EditAnywhere, Category = "CSV Content Settings" )
@@ -161,6 +208,21 @@ public:
 
 
 
+	// When true, localization directories are watched in the editor and rows changed in a loaded file are patched
+	// into its string table without reloading the whole table
+	UPROPERTY( config, EditAnywhere, Category = "Hot Reload" )
+	bool bHotReloadInEditor = true;
+
+	// Same as bHotReloadInEditor, for Debug and Development game builds. Hot reload is never available in shipping builds
+	UPROPERTY( config, EditAnywhere, Category = "Hot Reload" )
+	bool bHotReloadInDevelopmentBuilds = false;
+
+	// Seconds to wait after a file last changed before reloading it. Editors often write a file several times when saving
+	UPROPERTY( config, EditAnywhere, AdvancedDisplay, Category = "Hot Reload", meta = ( ClampMin = "0.0" ) )
+	float HotReloadDelay = 0.5f;
+
+
+
 	// WARNING: Changing this string will break any existing FText entries that are saved in Blueprints. Set it once at the start of the project and never change it.
 	UPROPERTY( config, EditAnywhere, AdvancedDisplay, Category = "Internal Settings" )
 	FString StringtableID = "Game";
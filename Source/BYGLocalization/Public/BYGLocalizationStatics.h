@@ -6,6 +6,8 @@
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "BYGLocalizationStatics.generated.h"
 
+DECLARE_DYNAMIC_DELEGATE_OneParam( FBYGOnLocalizationSetSignature, bool, bSuccess );
+
 UCLASS()
 class BYGLOCALIZATION_API UBYGLocalizationStatics : public UBlueprintFunctionLibrary
 {
@@ -15,6 +17,14 @@ public:
 	UFUNCTION( BlueprintCallable, Category = "BYG|Localization" )
 	static FText GetGameText( const FString& Key );
 
+	// Same as calling GetGameText for each key, but the string tables are only resolved once.
+	// Texts has one entry per key and Missing is true for keys that were in neither table. Returns the number of missing keys
+	UFUNCTION( BlueprintCallable, Category = "BYG|Localization" )
+	static int32 GetGameTexts( const TArray<FString>& Keys, TArray<FText>& Texts, TArray<bool>& Missing );
+
+	// C++ version of GetGameTexts, bit i of OutMissing is set if Keys[ i ] was missing
+	static int32 GetGameTextBatch( const TArray<FString>& Keys, TArray<FText>& OutTexts, TBitArray<>& OutMissing );
+
 	// Returns false if either table or text does not exist
 	UFUNCTION( BlueprintCallable, Category = "BYG|Localization" )
 	static bool HasTextInTable( const FString& TableName, const FString& Key );
@@ -25,4 +35,15 @@ public:
 	// can lead to multiple localizations of the same locale.
 	UFUNCTION( BlueprintCallable, Category = "BYG|Localization" )
 	static bool SetLocalizationFromFile( const FString& Path );
+
+	// Same as SetLocalizationFromFile, but the file is loaded on a background thread while the current localization
+	// stays in use. The new one is swapped in on the game thread and then OnComplete is called.
+	// If loading fails the current localization is kept
+	UFUNCTION( BlueprintCallable, Category = "BYG|Localization" )
+	static void SetLocalizationFromFileAsync( const FString& Path, const FBYGOnLocalizationSetSignature& OnComplete );
+
+	// Starts loading a localization in the background, e.g. during a splash screen, so a later
+	// SetLocalizationFromFileAsync with the same path is close to instant
+	UFUNCTION( BlueprintCallable, Category = "BYG|Localization" )
+	static void PreloadLocalizationFromFile( const FString& Path );
 };
@@ -24,6 +24,7 @@ public class BYGLocalizationEditor : ModuleRules
 				"InputCore",
                 "EditorStyle",
 				"FunctionalTesting",
+				"Json",
 
 				// UIStyle stuff
 				"Projects",
@@ -13,7 +13,10 @@
 #include "Editor/WorkspaceMenuStructure/Public/WorkspaceMenuStructure.h"
 #include "Widgets/Docking/SDockTab.h"
 
+#include "BYGLocalization/Public/BYGLocalization.h"
 #include "BYGLocalization/Public/BYGLocalizationSettings.h"
+#include "BYGLocalization/Private/BYGStringTableLoader.h"
+#include "BYGLocalizationModule.h"
 #include "BYGLocalizationUIStyle.h"
 
 #define LOCTEXT_NAMESPACE "BYGLocalizationEditorModule"
@@ -56,6 +59,8 @@ void FBYGLocalizationEditorModule::StartupModule()
 	FBYGLocalizationUIStyle::Initialize();
 
 
+	CompileLocalizationsForCook();
+
 	FGlobalTabmanager::Get()->RegisterNomadTabSpawner( BYGLocalizationModule::LocalizationStatsTabName, FOnSpawnTab::CreateStatic( &SpawnStatsTab ) )
 		.SetDisplayName( NSLOCTEXT( "BYGLocalization", "TestTab", "BYG Localization Stats" ) )
 		.SetTooltipText( NSLOCTEXT( "BYGLocalization", "TestTooltipText", "Open a window with info on localizations." ) )
@@ -86,6 +91,20 @@ bool FBYGLocalizationEditorModule::HandleSettingsSaved()
 	return true;
 }
 
+void FBYGLocalizationEditorModule::CompileLocalizationsForCook()
+{
+	FString CommandletName;
+	if ( !IsRunningCommandlet() || !FParse::Value( FCommandLine::Get(), TEXT( "run=" ), CommandletName ) || !CommandletName.Equals( TEXT( "cook" ), ESearchCase::IgnoreCase ) )
+		return;
+
+	if ( !GetDefault<UBYGLocalizationSettings>()->bUseCompiledLocalizations )
+		return;
+
+	// The compiled files sit next to the CSVs, so they are staged along with them and packaged builds never have
+	// to write them
+	FBYGStringTableLoader::CompileAll( *FBYGLocalizationModule::Get().GetLocalization()->GetLocalizationFilesSnapshot() );
+}
+
 
 #undef LOCTEXT_NAMESPACE
 
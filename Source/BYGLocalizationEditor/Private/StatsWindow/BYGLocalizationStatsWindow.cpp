@@ -2,11 +2,13 @@
 
 #include "BYGLocalizationStatsWindow.h"
 
+#include "HAL/FileManager.h"
 #include "Interfaces/IPluginManager.h"
 
 #include "Widgets/Views/SExpanderArrow.h"
 
 #include "BYGLocalization/Public/BYGLocalization.h"
+#include "BYGLocalization/Public/BYGLocalizationSettings.h"
 #include "BYGLocalizationEditor/Private/BYGLocalizationUIStyle.h"
 #include "BYGLocalizationModule.h"
 
@@ -14,7 +16,12 @@
 
 SBYGLocalizationStatsWindow::~SBYGLocalizationStatsWindow()
 {
-	CleanupThreads();
+	CancelStatsJob();
+
+	if ( bStatsCacheDirty )
+	{
+		StatsCache.Save( FBYGStatsCache::GetDefaultPath() );
+	}
 }
 
 void SBYGLocalizationStatsWindow::Construct( const FArguments& InArgs )
@@ -58,23 +65,28 @@ void SBYGLocalizationStatsWindow::Construct( const FArguments& InArgs )
 						]
 					]
 				]
-				#if 0
 				+ SHorizontalBox::Slot()
 				.AutoWidth()
 				[
 					SNew( SButton )
+					.ButtonStyle( FEditorStyle::Get(), "FlatButton.Default" )
+					.TextStyle( FEditorStyle::Get(), "FlatButton.DefaultTextStyle" )
 					.OnClicked( this, &SBYGLocalizationStatsWindow::CancelAll )
+					.Visibility( this, &SBYGLocalizationStatsWindow::GetProgressVisibility )
 					[
 						SNew( SHorizontalBox )
 						+ SHorizontalBox::Slot()
+						.VAlign( VAlign_Center )
+						.Padding( FMargin( 0, 0, 2, 0 ) )
 						.AutoWidth()
 						[
 							SNew( STextBlock )
 							.Font( FEditorStyle::Get().GetFontStyle( "FontAwesome.11" ) )
 							.TextStyle(FEditorStyle::Get(), "ContentBrowser.TopBar.Font")
-							.Text( FText::FromString( FString( TEXT( "\xf01e" ) ) ) /*fa-folder-open*/ )
+							.Text( FText::FromString( FString( TEXT( "\xf00d" ) ) ) /*fa-times*/ )
 						]
 						+ SHorizontalBox::Slot()
+						.VAlign( VAlign_Center )
 						.AutoWidth()
 						[
 							SNew( STextBlock )
@@ -82,12 +94,20 @@ void SBYGLocalizationStatsWindow::Construct( const FArguments& InArgs )
 						]
 					]
 				]
-				#endif
 				+ SHorizontalBox::Slot()
 				.AutoWidth()
 				[
 					SAssignNew( StatusThrobber, SCircularThrobber )
-					.Visibility( EVisibility::Hidden )
+					.Visibility( this, &SBYGLocalizationStatsWindow::GetProgressVisibility )
+				]
+				+ SHorizontalBox::Slot()
+				.VAlign( VAlign_Center )
+				.Padding( FMargin( 4, 0, 0, 0 ) )
+				.AutoWidth()
+				[
+					SNew( STextBlock )
+					.Text( this, &SBYGLocalizationStatsWindow::GetProgressText )
+					.Visibility( this, &SBYGLocalizationStatsWindow::GetProgressVisibility )
 				]
 			]
 			+ SVerticalBox::Slot()
@@ -119,6 +139,8 @@ void SBYGLocalizationStatsWindow::Construct( const FArguments& InArgs )
 		]
 	];
 
+	StatsCache.Load( FBYGStatsCache::GetDefaultPath(), *GetDefault<UBYGLocalizationSettings>() );
+
 	RefreshAll();
 }
 
@@ -233,20 +255,28 @@ TSharedPtr<SWidget> SBYGLocalizationStatsWindow::GetListContextMenu()
 		#endif
 }
 
-void SBYGLocalizationStatsWindow::CleanupThreads()
+void SBYGLocalizationStatsWindow::CancelStatsJob()
 {
-	ParseFileRunnable.Reset();
+	if ( StatsJob.IsValid() )
+	{
+		// Any tasks still running hold on to the job, so there's nothing to wait for
+		StatsJob->Cancel();
+		StatsJob.Reset();
+	}
 }
 
 FReply SBYGLocalizationStatsWindow::RefreshAll()
 {
-	CleanupThreads();
+	CancelStatsJob();
 
 	// Reload all
 
 	// Load the data I guess?
 	Items.Empty();
 
+	// Pick up files added since the last refresh, even when nothing is watching the directories
+	FBYGLocalizationModule::Get().GetLocalization()->InvalidateLocalizationFiles();
+
 	TArray<FBYGLocaleInfo> Entries = FBYGLocalizationModule::Get().GetLocalization()->GetAvailableLocalizations();
 
 	TArray<FString> Paths;
@@ -254,52 +284,147 @@ FReply SBYGLocalizationStatsWindow::RefreshAll()
 	for ( const FBYGLocaleInfo& Entry : Entries )
 	{
 		const FString FullPath = FPaths::Combine( FPaths::ProjectContentDir(), Entry.FilePath );
-		Paths.Add( FullPath );
 
 		TSharedRef<FBYGLocalizationStatEntry> NewItem = FBYGLocalizationStatEntry::Create();
 		NewItem->LocaleCode = Entry.LocaleCode;
 		NewItem->Language = Entry.LocalizedName;
-		NewItem->Path = FPaths::Combine( FPaths::ProjectContentDir(), Entry.FilePath );
-		NewItem->bIsRefreshing = true;
+		NewItem->Path = FullPath;
+
+		// Only a stat, so unchanged files cost nothing to refresh
+		const FFileStatData StatData = IFileManager::Get().GetStatData( *FullPath );
+		const FBYGStatsCache::FEntry* Cached = StatData.bIsValid
+			? StatsCache.FindUnchanged( FullPath, StatData.FileSize, StatData.ModificationTime )
+			: nullptr;
+		if ( Cached )
+		{
+			SetEntryStats( *NewItem, Cached->Stats );
+		}
+		else
+		{
+			NewItem->bIsRefreshing = true;
+			Paths.Add( FullPath );
+		}
 		Items.Add( NewItem );
 	}
 
-	ParseFileRunnable = MakeShareable( new FBYGParseFileRunnable( Paths ) );
-	if ( ParseFileRunnable )
+	if ( StatsList.IsValid() )
 	{
-		ParseFileRunnable->OnGetStatsCompleteSignature.BindRaw( this, &SBYGLocalizationStatsWindow::OnFileParseComplete );
+		StatsList->RequestListRefresh();
+	}
+
+	if ( Paths.Num() > 0 )
+	{
+		// Resolve the module here on the game thread, the job's tasks only ever see the localization object
+		StatsJob = FBYGLocStatsJob::Launch( *FBYGLocalizationModule::Get().GetLocalization(), Paths, &StatsCache );
+		if ( !DrainTimerHandle.IsValid() )
+		{
+			DrainTimerHandle = RegisterActiveTimer( 0.0f, FWidgetActiveTimerDelegate::CreateSP( this, &SBYGLocalizationStatsWindow::DrainStatsJob ) );
+		}
 	}
 
 	return FReply::Handled();
 }
 
-void SBYGLocalizationStatsWindow::OnFileParseComplete( const FString& Path, const BYGLocStats& LocStats )
+EActiveTimerReturnType SBYGLocalizationStatsWindow::DrainStatsJob( double InCurrentTime, float InDeltaTime )
 {
+	if ( StatsJob.IsValid() )
+	{
+		const bool bFinished = StatsJob->Drain( [this]( const FBYGLocStatsJob::FResult& Result )
+		{
+			OnFileParseComplete( Result );
+		} );
+		if ( !bFinished )
+			return EActiveTimerReturnType::Continue;
+
+		StatsJob.Reset();
+	}
+
+	if ( bStatsCacheDirty )
+	{
+		StatsCache.Save( FBYGStatsCache::GetDefaultPath() );
+		bStatsCacheDirty = false;
+	}
+
+	DrainTimerHandle.Reset();
+	return EActiveTimerReturnType::Stop;
+}
+
+void SBYGLocalizationStatsWindow::OnFileParseComplete( const FBYGLocStatsJob::FResult& Result )
+{
+	if ( Result.bSucceeded )
+	{
+		FBYGStatsCache::FEntry CacheEntry;
+		CacheEntry.Size = Result.Size;
+		CacheEntry.Timestamp = Result.Timestamp;
+		CacheEntry.Hash = Result.Hash;
+		CacheEntry.Stats = Result.Stats;
+		StatsCache.Add( Result.Path, CacheEntry );
+		bStatsCacheDirty = true;
+	}
+
 	// Find the data for this one
 	for ( TSharedPtr<FBYGLocalizationStatEntry> Entry : Items )
 	{
 		if ( !Entry.IsValid() )
 			continue;
 
-		if ( Entry->Path == Path )
+		if ( Entry->Path == Result.Path )
 		{
 			Entry->bIsRefreshing = false;
-			Entry->NormalEntries = LocStats[ EBYGLocEntryStatus::None ];
-			Entry->NewEntries = LocStats[ EBYGLocEntryStatus::New ];
-			Entry->ModifiedEntries = LocStats[ EBYGLocEntryStatus::Modified ];
-			Entry->DeprecatedEntries = LocStats[ EBYGLocEntryStatus::Deprecated ];
-			Entry->TotalEntries = LocStats[ EBYGLocEntryStatus::None ] + LocStats[ EBYGLocEntryStatus::New ] + LocStats[ EBYGLocEntryStatus::Modified ];
+			if ( !Result.bSucceeded )
+			{
+				Entry->Status = LOCTEXT( "ReadFailed", "Could not read file" );
+				break;
+			}
+			SetEntryStats( *Entry, Result.Stats );
 			break;
 		}
 	}
 }
 
+void SBYGLocalizationStatsWindow::SetEntryStats( FBYGLocalizationStatEntry& Entry, const BYGLocStats& LocStats )
+{
+	Entry.bIsRefreshing = false;
+	Entry.Status = FText::GetEmpty();
+	Entry.NormalEntries = LocStats[ EBYGLocEntryStatus::None ];
+	Entry.NewEntries = LocStats[ EBYGLocEntryStatus::New ];
+	Entry.ModifiedEntries = LocStats[ EBYGLocEntryStatus::Modified ];
+	Entry.DeprecatedEntries = LocStats[ EBYGLocEntryStatus::Deprecated ];
+	Entry.TotalEntries = LocStats[ EBYGLocEntryStatus::None ] + LocStats[ EBYGLocEntryStatus::New ] + LocStats[ EBYGLocEntryStatus::Modified ];
+}
+
 
 FReply SBYGLocalizationStatsWindow::CancelAll()
 {
+	CancelStatsJob();
+
+	for ( TSharedPtr<FBYGLocalizationStatEntry> Entry : Items )
+	{
+		if ( Entry.IsValid() && Entry->bIsRefreshing )
+		{
+			Entry->bIsRefreshing = false;
+			Entry->Status = LOCTEXT( "Cancelled", "Cancelled" );
+		}
+	}
+
 	return FReply::Handled();
 }
 
+FText SBYGLocalizationStatsWindow::GetProgressText() const
+{
+	if ( !StatsJob.IsValid() )
+		return FText::GetEmpty();
+
+	return FText::Format( LOCTEXT( "Progress", "Reading {0} of {1} files..." ),
+		FText::AsNumber( StatsJob->GetNumFinished() ),
+		FText::AsNumber( StatsJob->GetNumFiles() ) );
+}
+
+EVisibility SBYGLocalizationStatsWindow::GetProgressVisibility() const
+{
+	return StatsJob.IsValid() ? EVisibility::Visible : EVisibility::Hidden;
+}
+
 void SBYGLocalizationStatsWindow::OpenFolder()
 {
 	TArray<TSharedPtr<FBYGLocalizationStatEntry>> SelectedItems;
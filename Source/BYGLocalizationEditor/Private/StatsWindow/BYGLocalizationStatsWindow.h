@@ -12,7 +12,8 @@
 #include "Widgets/Views/STableRow.h"
 #include "Widgets/Images/SThrobber.h"
 #include "BYGLocalization/Public/BYGLocalization.h"
-#include "BYGLocalization/Private/BYGParseFileRunnable.h"
+#include "BYGLocalization/Private/BYGLocStatsJob.h"
+#include "BYGLocalization/Private/BYGStatsCache.h"
 
 #define LOCTEXT_NAMESPACE "BYGLocalization"
 
@@ -47,8 +48,9 @@ public:
 
 	void Construct( const FArguments& InArgs );
 
-	void OnFileParseComplete( const FString& Path, const BYGLocStats& LocStats );
 protected:
+	void OnFileParseComplete( const FBYGLocStatsJob::FResult& Result );
+	static void SetEntryStats( FBYGLocalizationStatEntry& Entry, const BYGLocStats& LocStats );
 	TSharedRef<ITableRow> OnGenerateWidgetForList( TSharedPtr<FBYGLocalizationStatEntry> InItem, const TSharedRef<STableViewBase>& OwnerTable );
 	TSharedPtr<SWidget> GetListContextMenu();
 
@@ -66,9 +68,18 @@ protected:
 
 	FReply RefreshAll();
 	FReply CancelAll();
-	void CleanupThreads();
-	// Could be TUniquePtr?
-	TSharedPtr<FBYGParseFileRunnable> ParseFileRunnable;
+	void CancelStatsJob();
+	// Runs on the game thread while the stats job is in progress, handing its results to the list
+	EActiveTimerReturnType DrainStatsJob( double InCurrentTime, float InDeltaTime );
+	FText GetProgressText() const;
+	EVisibility GetProgressVisibility() const;
+
+	TSharedPtr<FBYGLocStatsJob, ESPMode::ThreadSafe> StatsJob;
+	TSharedPtr<FActiveTimerHandle> DrainTimerHandle;
+
+	// Files that haven't changed since the last scan are filled in from here without being read
+	FBYGStatsCache StatsCache;
+	bool bStatsCacheDirty = false;
 
 	TSharedPtr<SCircularThrobber> StatusThrobber;
 };
@@ -0,0 +1,519 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#include "Runtime/Launch/Resources/Version.h"
+// Unit testing did not exist before 4.22
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION > 22
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#include "BYGLocalization/Public/BYGLocalization.h"
+#include "BYGLocalization/Private/BYGGameTextCache.h"
+
+#include "Developer/FunctionalTesting/Classes/FunctionalTestBase.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProperties.h"
+#include "Internationalization/StringTableCore.h"
+#include "Internationalization/StringTableRegistry.h"
+#include "Math/RandomStream.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include <BYGLocalizationSettings.h>
+#include "BYGLocalizationTestHelpers.h"
+
+// Benchmarks over generated localization files. Not part of the product tests, run them with e.g.
+// UnrealEditor-Cmd <Project> -ExecCmds="Automation RunTests BYG.Localization.Perf; Quit" -unattended -nullrhi
+// Results are merged into Saved/BYGLocalization/PerfReport.json, or the path given with -BYGPerfReport=
+// -BYGPerfLarge adds a million-row file, which takes a few minutes
+
+static const int PerfTestFlags = (
+	EAutomationTestFlags::EditorContext
+	| EAutomationTestFlags::CommandletContext
+	| EAutomationTestFlags::ClientContext
+	| EAutomationTestFlags::PerfFilter );
+
+
+// Lets the benchmarks call the protected file functions without befriending every test
+class FBYGPerfTestAccess
+{
+public:
+	static bool WriteCSV( UBYGLocalization& Loc, const FBYGLocaleData& Data, const FString& Filename, uint64* OutHash = nullptr, const uint64* ExistingHash = nullptr )
+	{
+		return Loc.WriteCSV( Data, Filename, nullptr, OutHash, ExistingHash );
+	}
+	static bool GetLocalizationDataFromFile( const UBYGLocalization& Loc, const FString& Filename, FBYGLocaleData& Data )
+	{
+		return Loc.GetLocalizationDataFromFile( Filename, Data );
+	}
+};
+
+namespace BYGPerf
+{
+	enum class ECorpusStyle : uint8
+	{
+		// Menu items and labels
+		Short,
+		// A few sentences per row
+		Dialogue,
+		// Commas, quotes, newlines and backslashes in every row
+		Quoted
+	};
+
+	struct FCorpus
+	{
+		FString Name;
+		int32 NumRows;
+		ECorpusStyle Style;
+	};
+
+	static TArray<FCorpus> GetCorpora()
+	{
+		TArray<FCorpus> Corpora = {
+			{ TEXT( "1k_short" ), 1000, ECorpusStyle::Short },
+			{ TEXT( "100k_short" ), 100000, ECorpusStyle::Short },
+			{ TEXT( "100k_dialogue" ), 100000, ECorpusStyle::Dialogue },
+			{ TEXT( "100k_quoted" ), 100000, ECorpusStyle::Quoted },
+		};
+		if ( FParse::Param( FCommandLine::Get(), TEXT( "BYGPerfLarge" ) ) )
+		{
+			Corpora.Add( { TEXT( "1M_short" ), 1000000, ECorpusStyle::Short } );
+		}
+		return Corpora;
+	}
+
+	// Small files are quick enough to take the best of a few runs
+	static int32 GetNumRuns( const FCorpus& Corpus )
+	{
+		return Corpus.NumRows > 100000 ? 1 : 3;
+	}
+
+	static FString MakeValue( int32 Row, ECorpusStyle Style, FRandomStream& Random )
+	{
+		static const TCHAR* Words[] = {
+			TEXT( "the" ), TEXT( "sword" ), TEXT( "village" ), TEXT( "ancient" ), TEXT( "we" ), TEXT( "must" ),
+			TEXT( "travel" ), TEXT( "north" ), TEXT( "before" ), TEXT( "winter" ), TEXT( "comes" ), TEXT( "and" ),
+			TEXT( "\u00e9lan" ), TEXT( "na\u00efve" ), TEXT( "\u00fcber" ), TEXT( "se\u00f1or" ), TEXT( "caf\u00e9" ), TEXT( "d\u00e9j\u00e0" ),
+		};
+
+		switch ( Style )
+		{
+		case ECorpusStyle::Short:
+			return FString::Printf( TEXT( "Menu item %d" ), Row );
+
+		case ECorpusStyle::Dialogue:
+		{
+			FString Value;
+			const int32 NumWords = Random.RandRange( 40, 80 );
+			Value.Reserve( NumWords * 8 );
+			for ( int32 i = 0; i < NumWords; ++i )
+			{
+				Value += Words[ Random.RandHelper( UE_ARRAY_COUNT( Words ) ) ];
+				Value += ( i % 12 == 11 ) ? TEXT( ". " ) : TEXT( " " );
+			}
+			return Value;
+		}
+
+		case ECorpusStyle::Quoted:
+		default:
+			return FString::Printf( TEXT( "He said, \"Stop, %s!\" and left.\nRow %d, with a \\ backslash" ),
+				Words[ Random.RandHelper( UE_ARRAY_COUNT( Words ) ) ], Row );
+		}
+	}
+
+	// The same corpus every run, so results can be compared between runs
+	static TArray<FBYGLocalizationEntry> MakeEntries( const FCorpus& Corpus )
+	{
+		FRandomStream Random( 1234 );
+
+		TArray<FBYGLocalizationEntry> Entries;
+		Entries.Reserve( Corpus.NumRows );
+		for ( int32 i = 0; i < Corpus.NumRows; ++i )
+		{
+			Entries.Emplace(
+				FString::Printf( TEXT( "Key_%07d" ), i ),
+				MakeValue( i, Corpus.Style, Random ),
+				( i % 10 == 0 ) ? TEXT( "Shown in the pause menu" ) : TEXT( "" ) );
+		}
+		return Entries;
+	}
+
+	template<typename FuncType>
+	static double TimeBestOf( int32 NumRuns, FuncType&& Func )
+	{
+		double BestSeconds = MAX_dbl;
+		for ( int32 i = 0; i < NumRuns; ++i )
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			Func();
+			BestSeconds = FMath::Min( BestSeconds, FPlatformTime::Seconds() - StartTime );
+		}
+		return BestSeconds;
+	}
+
+	static double ToMB( int64 Bytes )
+	{
+		return Bytes / ( 1024.0 * 1024.0 );
+	}
+
+	static FString MakeTempDirectory()
+	{
+		const FString Directory = FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGPerf" ) );
+		IFileManager::Get().MakeDirectory( *Directory, true );
+		return Directory;
+	}
+
+	static UBYGLocalizationSettings* MakeSettings( const FString& Directory )
+	{
+		UBYGLocalizationSettings* Settings = NewObject<UBYGLocalizationSettings>();
+		Settings->PrimaryLocalizationDirectory.Path = Directory;
+		Settings->AdditionalLocalizationDirectories.Empty();
+		Settings->PrimaryLanguageCode = TEXT( "en" );
+		Settings->FilenamePrefix = TEXT( "loc_" );
+		Settings->FilenameSuffix = TEXT( "" );
+		Settings->PrimaryExtension = TEXT( "csv" );
+		Settings->bCreateBackup = false;
+		return Settings;
+	}
+
+	static FString GetReportPath()
+	{
+		FString Path;
+		if ( FParse::Value( FCommandLine::Get(), TEXT( "BYGPerfReport=" ), Path ) )
+			return Path;
+		return FPaths::Combine( FPaths::ProjectSavedDir(), TEXT( "BYGLocalization" ), TEXT( "PerfReport.json" ) );
+	}
+
+	// Results for one test, one object of metrics per corpus
+	class FReport
+	{
+	public:
+		FReport( FAutomationTestBase& InTest, const FString& InTestName )
+			: Test( InTest )
+			, TestName( InTestName )
+			, Results( MakeShared<FJsonObject>() )
+		{
+		}
+
+		void Add( const FString& Corpus, const FString& Metric, double Value )
+		{
+			const TSharedPtr<FJsonObject>* Existing = nullptr;
+			TSharedPtr<FJsonObject> Metrics;
+			if ( Results->TryGetObjectField( Corpus, Existing ) )
+			{
+				Metrics = *Existing;
+			}
+			else
+			{
+				Metrics = MakeShared<FJsonObject>();
+				Results->SetObjectField( Corpus, Metrics );
+			}
+			Metrics->SetNumberField( Metric, Value );
+
+			Test.AddInfo( FString::Printf( TEXT( "%s %s: %s = %.3f" ), *TestName, *Corpus, *Metric, Value ) );
+		}
+
+		// Merged into the existing report, so tests can be run one at a time
+		bool Save() const
+		{
+			const FString Path = GetReportPath();
+
+			TSharedPtr<FJsonObject> Root;
+			FString JsonString;
+			if ( !FFileHelper::LoadFileToString( JsonString, *Path, FFileHelper::EHashOptions::None, FILEREAD_Silent )
+				|| !FJsonSerializer::Deserialize( TJsonReaderFactory<>::Create( JsonString ), Root )
+				|| !Root.IsValid() )
+			{
+				Root = MakeShared<FJsonObject>();
+			}
+
+			// Describes the machine and build for whichever test ran last
+			Root->SetStringField( TEXT( "EngineVersion" ), FEngineVersion::Current().ToString() );
+			Root->SetStringField( TEXT( "Platform" ), FPlatformProperties::PlatformName() );
+			Root->SetStringField( TEXT( "Configuration" ), LexToString( FApp::GetBuildConfiguration() ) );
+			Root->SetStringField( TEXT( "CPU" ), FPlatformMisc::GetCPUBrand().TrimStartAndEnd() );
+			Root->SetNumberField( TEXT( "NumCores" ), FPlatformMisc::NumberOfCoresIncludingHyperthreads() );
+
+			const TSharedPtr<FJsonObject>* ExistingTests = nullptr;
+			TSharedPtr<FJsonObject> Tests = Root->TryGetObjectField( TEXT( "Tests" ), ExistingTests ) ? *ExistingTests : MakeShared<FJsonObject>();
+			TSharedRef<FJsonObject> TestResults = MakeShared<FJsonObject>();
+			TestResults->SetStringField( TEXT( "Timestamp" ), FDateTime::UtcNow().ToIso8601() );
+			TestResults->SetObjectField( TEXT( "Results" ), Results );
+			Tests->SetObjectField( TestName, TestResults );
+			Root->SetObjectField( TEXT( "Tests" ), Tests );
+
+			JsonString.Reset();
+			return FJsonSerializer::Serialize( Root.ToSharedRef(), TJsonWriterFactory<>::Create( &JsonString ) )
+				&& FFileHelper::SaveStringToFile( JsonString, *Path );
+		}
+
+	protected:
+		FAutomationTestBase& Test;
+		const FString TestName;
+		TSharedRef<FJsonObject> Results;
+	};
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGPerfParseTest, FFunctionalTestBase, "BYG.Localization.Perf.Parse", PerfTestFlags )
+bool FBYGPerfParseTest::RunTest( const FString& Parameters )
+{
+	using namespace BYGPerf;
+
+	const FString Directory = MakeTempDirectory();
+	UBYGLocalization* Loc = new UBYGLocalization();
+	Loc->Construct( MakeShared<UBYGLocalizationSettingsTestProvider>( MakeSettings( Directory ) ) );
+
+	FReport Report( *this, TEXT( "Parse" ) );
+	for ( const FCorpus& Corpus : GetCorpora() )
+	{
+		const FString Path = FPaths::Combine( Directory, Corpus.Name + TEXT( ".csv" ) );
+		TestTrue( Corpus.Name + " write", FBYGPerfTestAccess::WriteCSV( *Loc, FBYGLocaleData( MakeEntries( Corpus ) ), Path ) );
+		const int64 Bytes = IFileManager::Get().FileSize( *Path );
+
+		int32 NumEntries = 0;
+		const double Seconds = TimeBestOf( GetNumRuns( Corpus ), [&]()
+		{
+			FBYGLocaleData Data;
+			FBYGPerfTestAccess::GetLocalizationDataFromFile( *Loc, Path, Data );
+			NumEntries = Data.Num();
+		} );
+		TestEqual( Corpus.Name + " rows", NumEntries, Corpus.NumRows );
+
+		Report.Add( Corpus.Name, TEXT( "Seconds" ), Seconds );
+		Report.Add( Corpus.Name, TEXT( "RowsPerSecond" ), Corpus.NumRows / Seconds );
+		Report.Add( Corpus.Name, TEXT( "MBPerSecond" ), ToMB( Bytes ) / Seconds );
+	}
+	TestTrue( "Save report", Report.Save() );
+
+	delete Loc;
+	IFileManager::Get().DeleteDirectory( *Directory, false, true );
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGPerfWriteCSVTest, FFunctionalTestBase, "BYG.Localization.Perf.WriteCSV", PerfTestFlags )
+bool FBYGPerfWriteCSVTest::RunTest( const FString& Parameters )
+{
+	using namespace BYGPerf;
+
+	const FString Directory = MakeTempDirectory();
+	UBYGLocalization* Loc = new UBYGLocalization();
+	Loc->Construct( MakeShared<UBYGLocalizationSettingsTestProvider>( MakeSettings( Directory ) ) );
+
+	FReport Report( *this, TEXT( "WriteCSV" ) );
+	for ( const FCorpus& Corpus : GetCorpora() )
+	{
+		const FBYGLocaleData Data( MakeEntries( Corpus ) );
+		const FString Path = FPaths::Combine( Directory, Corpus.Name + TEXT( ".csv" ) );
+
+		// Time each write into an empty directory, so it's always a new file
+		double BestSeconds = MAX_dbl;
+		uint64 Hash = 0;
+		for ( int32 i = 0; i < GetNumRuns( Corpus ); ++i )
+		{
+			IFileManager::Get().Delete( *Path );
+			BestSeconds = FMath::Min( BestSeconds, TimeBestOf( 1, [&]()
+			{
+				FBYGPerfTestAccess::WriteCSV( *Loc, Data, Path, &Hash );
+			} ) );
+		}
+		const int64 Bytes = IFileManager::Get().FileSize( *Path );
+		TestTrue( Corpus.Name + " written", Bytes > 0 );
+
+		// Writing the same contents again only serializes and hashes them, the file isn't touched
+		const double UnchangedSeconds = TimeBestOf( GetNumRuns( Corpus ), [&]()
+		{
+			FBYGPerfTestAccess::WriteCSV( *Loc, Data, Path, nullptr, &Hash );
+		} );
+
+		Report.Add( Corpus.Name, TEXT( "Seconds" ), BestSeconds );
+		Report.Add( Corpus.Name, TEXT( "MBPerSecond" ), ToMB( Bytes ) / BestSeconds );
+		Report.Add( Corpus.Name, TEXT( "UnchangedSeconds" ), UnchangedSeconds );
+	}
+	TestTrue( "Save report", Report.Save() );
+
+	delete Loc;
+	IFileManager::Get().DeleteDirectory( *Directory, false, true );
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGPerfStatsTest, FFunctionalTestBase, "BYG.Localization.Perf.Stats", PerfTestFlags )
+bool FBYGPerfStatsTest::RunTest( const FString& Parameters )
+{
+	using namespace BYGPerf;
+
+	const FString Directory = MakeTempDirectory();
+	UBYGLocalization* Loc = new UBYGLocalization();
+	Loc->Construct( MakeShared<UBYGLocalizationSettingsTestProvider>( MakeSettings( Directory ) ) );
+
+	FReport Report( *this, TEXT( "Stats" ) );
+	for ( const FCorpus& Corpus : GetCorpora() )
+	{
+		const FString Path = FPaths::Combine( Directory, Corpus.Name + TEXT( ".csv" ) );
+		FBYGPerfTestAccess::WriteCSV( *Loc, FBYGLocaleData( MakeEntries( Corpus ) ), Path );
+		const int64 Bytes = IFileManager::Get().FileSize( *Path );
+
+		BYGLocStats Stats;
+		const double Seconds = TimeBestOf( GetNumRuns( Corpus ), [&]()
+		{
+			Stats = BYGLocStats();
+			Loc->GetLocalizationStats( Path, Stats );
+		} );
+		TestEqual( Corpus.Name + " rows", Stats[ EBYGLocEntryStatus::None ], Corpus.NumRows );
+
+		Report.Add( Corpus.Name, TEXT( "Seconds" ), Seconds );
+		Report.Add( Corpus.Name, TEXT( "MBPerSecond" ), ToMB( Bytes ) / Seconds );
+	}
+	TestTrue( "Save report", Report.Save() );
+
+	delete Loc;
+	IFileManager::Get().DeleteDirectory( *Directory, false, true );
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGPerfUpdateTranslationsTest, FFunctionalTestBase, "BYG.Localization.Perf.UpdateTranslations", PerfTestFlags )
+bool FBYGPerfUpdateTranslationsTest::RunTest( const FString& Parameters )
+{
+	using namespace BYGPerf;
+
+	int32 NumLocales = 8;
+	FParse::Value( FCommandLine::Get(), TEXT( "BYGPerfLocales=" ), NumLocales );
+	static const TCHAR* LocaleCodes[] = {
+		TEXT( "fr" ), TEXT( "de" ), TEXT( "es" ), TEXT( "it" ), TEXT( "ja" ), TEXT( "ko" ), TEXT( "pt" ), TEXT( "ru" ),
+		TEXT( "pl" ), TEXT( "tr" ), TEXT( "nl" ), TEXT( "sv" ), TEXT( "cs" ), TEXT( "hu" ), TEXT( "uk" ), TEXT( "th" ),
+	};
+	NumLocales = FMath::Clamp( NumLocales, 1, (int32)UE_ARRAY_COUNT( LocaleCodes ) );
+
+	FReport Report( *this, TEXT( "UpdateTranslations" ) );
+	for ( const FCorpus& Corpus : GetCorpora() )
+	{
+		const FString Directory = MakeTempDirectory();
+		UBYGLocalizationSettings* Settings = MakeSettings( Directory );
+		UBYGLocalization* Loc = new UBYGLocalization();
+		Loc->Construct( MakeShared<UBYGLocalizationSettingsTestProvider>( Settings ) );
+
+		const TArray<FBYGLocalizationEntry> PrimaryEntries = MakeEntries( Corpus );
+		FBYGPerfTestAccess::WriteCSV( *Loc, FBYGLocaleData( PrimaryEntries ), FPaths::Combine( Directory, TEXT( "loc_en.csv" ) ) );
+
+		// Each locale is translated against the primary, minus a few rows so the update has something to do
+		for ( int32 i = 0; i < NumLocales; ++i )
+		{
+			TArray<FBYGLocalizationEntry> LocaleEntries;
+			LocaleEntries.Reserve( PrimaryEntries.Num() );
+			for ( int32 Row = 0; Row < PrimaryEntries.Num(); ++Row )
+			{
+				if ( Row % 20 == i )
+					continue;
+				FBYGLocalizationEntry& Entry = LocaleEntries.Add_GetRef( PrimaryEntries[ Row ] );
+				Entry.Primary = Entry.Translation;
+				Entry.Translation = FString::Printf( TEXT( "[%s] %s" ), LocaleCodes[ i ], *Entry.Translation );
+			}
+			FBYGPerfTestAccess::WriteCSV( *Loc, FBYGLocaleData( LocaleEntries ), FPaths::Combine( Directory, FString::Printf( TEXT( "loc_%s.csv" ), LocaleCodes[ i ] ) ) );
+		}
+
+		// Every file is merged and written
+		Settings->bIncrementalUpdate = false;
+		const double FullSeconds = TimeBestOf( 1, [&]()
+		{
+			TestTrue( Corpus.Name + " update", Loc->UpdateTranslations() );
+		} );
+
+		// The first incremental update writes the manifest, the second finds nothing to do
+		Settings->bIncrementalUpdate = true;
+		Loc->UpdateTranslations();
+		const double NoOpSeconds = TimeBestOf( GetNumRuns( Corpus ), [&]()
+		{
+			Loc->UpdateTranslations();
+		} );
+
+		Report.Add( Corpus.Name, TEXT( "NumLocales" ), NumLocales );
+		Report.Add( Corpus.Name, TEXT( "Seconds" ), FullSeconds );
+		Report.Add( Corpus.Name, TEXT( "RowsPerSecond" ), (double)Corpus.NumRows * NumLocales / FullSeconds );
+		Report.Add( Corpus.Name, TEXT( "NoOpSeconds" ), NoOpSeconds );
+
+		delete Loc;
+		IFileManager::Get().DeleteDirectory( *Directory, false, true );
+	}
+	TestTrue( "Save report", Report.Save() );
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGPerfGameTextTest, FFunctionalTestBase, "BYG.Localization.Perf.GameText", PerfTestFlags )
+bool FBYGPerfGameTextTest::RunTest( const FString& Parameters )
+{
+	using namespace BYGPerf;
+
+	const FName TableID( TEXT( "BYGPerfGameText" ) );
+
+	FReport Report( *this, TEXT( "GameText" ) );
+	for ( const FCorpus& Corpus : GetCorpora() )
+	{
+		// Lookup cost doesn't depend on the length of the values
+		if ( Corpus.Style != ECorpusStyle::Short )
+			continue;
+
+		const TArray<FBYGLocalizationEntry> Entries = MakeEntries( Corpus );
+		TArray<FString> Keys;
+		Keys.Reserve( Entries.Num() );
+
+		FStringTableRef Table = FStringTable::NewStringTable();
+		Table->SetNamespace( TEXT( "BYGPerf" ) );
+		for ( const FBYGLocalizationEntry& Entry : Entries )
+		{
+			Table->SetSourceString( Entry.Key, Entry.Translation );
+			Keys.Add( Entry.Key );
+		}
+		FStringTableRegistry::Get().RegisterStringTable( TableID, Table );
+
+		FBYGGameTextCache Cache( TableID, NAME_None );
+		FText FoundText;
+
+		// The first lookup of each key creates its FText
+		const double FirstSeconds = TimeBestOf( 1, [&]()
+		{
+			for ( const FString& Key : Keys )
+			{
+				Cache.Find( Key, FoundText );
+			}
+		} );
+
+		// Then they are all cached
+		const int32 NumLookups = FMath::Max( Keys.Num(), 1000000 );
+		int32 NumAllocations = 0;
+		double CachedSeconds = 0.0;
+		{
+			FBYGCountingMalloc CountingMalloc;
+			CachedSeconds = TimeBestOf( 1, [&]()
+			{
+				for ( int32 i = 0; i < NumLookups; ++i )
+				{
+					Cache.Find( Keys[ i % Keys.Num() ], FoundText );
+				}
+			} );
+			NumAllocations = CountingMalloc.GetNumAllocations();
+		}
+		TestEqual( Corpus.Name + " allocations for cached lookups", NumAllocations, 0 );
+
+		Report.Add( Corpus.Name, TEXT( "FirstLookupsPerSecond" ), Keys.Num() / FirstSeconds );
+		Report.Add( Corpus.Name, TEXT( "LookupsPerSecond" ), NumLookups / CachedSeconds );
+		Report.Add( Corpus.Name, TEXT( "AllocationsPerLookup" ), (double)NumAllocations / NumLookups );
+
+		FStringTableRegistry::Get().UnregisterStringTable( TableID );
+	}
+	TestTrue( "Save report", Report.Save() );
+
+	return true;
+}
+
+
+#endif
@@ -2,20 +2,34 @@
 
 #include "Runtime/Launch/Resources/Version.h"
 // Unit testing did not exist before 4.22
-#if ENGINE_MINOR_VERSION > 22
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION > 22
 
 #include "CoreMinimal.h"
 #include "Misc/AutomationTest.h"
 
 #include "BYGLocalization/Public/BYGLocalizationStatics.h"
 #include "BYGLocalization/Public/BYGLocalization.h"
+#include "BYGLocalization/Private/BYGCSVParser.h"
+#include "BYGLocalization/Private/BYGCultureCache.h"
+#include "BYGLocalization/Private/BYGGameTextCache.h"
+#include "BYGLocalization/Private/BYGStatsCache.h"
+#include "BYGLocalization/Private/BYGStatusMatcher.h"
+#include "BYGLocalization/Private/BYGStringTableLoader.h"
 
 #include "Editor/UnrealEd/Public/Tests/AutomationEditorCommon.h"
 #include "Developer/FunctionalTesting/Classes/FunctionalTestBase.h"
 #include "Core/Public/Misc/FileHelper.h"
-#include <Windows/WindowsPlatformProcess.h>
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Internationalization/Internationalization.h"
+#include "Internationalization/StringTableCore.h"
+#include "Internationalization/StringTableRegistry.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/PlatformProcess.h"
 #include <HAL/PlatformFilemanager.h>
 #include <BYGLocalizationSettings.h>
+#include "BYGLocalizationTestHelpers.h"
 
 	// Stuff to test:
 	// General CSV stuff
@@ -37,17 +51,6 @@ static const int TestFlags = (
 	| EAutomationTestFlags::ProductFilter );
 
 
-class UBYGLocalizationSettingsTestProvider : public IBYGLocalizationSettingsProvider
-{
-public:
-	virtual const UBYGLocalizationSettings* GetSettings() const override
-	{
-		return Blah;
-	}
-protected:
-	UBYGLocalizationSettings* Blah;
-};
-
 IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGLocalizationTest, FFunctionalTestBase, "BYG.Localization.Parse", TestFlags )
 bool FBYGLocalizationTest::RunTest( const FString& Parameters )
 {
@@ -121,6 +124,231 @@ bool FBYGLocalizationTest::RunTest( const FString& Parameters )
 }
 
 
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGCSVParserTest, FFunctionalTestBase, "BYG.Localization.CSVParser", TestFlags )
+bool FBYGCSVParserTest::RunTest( const FString& Parameters )
+{
+	struct FData
+	{
+		const FString Input;
+		const TArray<TArray<FString>> ExpectedRows;
+	};
+	// Mirrors the cases in BYG.Localization.Parse, but checks our parser directly
+	const TMap<FString, FData> Data = {
+		{ "Simple test", { "Hello_World,Salut world,", { { "Hello_World", "Salut world", "" } } } },
+		{ "Quotes around keys", { "\"Hello World\",Salut world,", { { "Hello World", "Salut world", "" } } } },
+		{ "Quotes around keys with commas", { "\"Hello, World\",Salut world,", { { "Hello, World", "Salut world", "" } } } },
+		{ "Quotes around value with commas", { "Hello_World,\"Salut, world\",", { { "Hello_World", "Salut, world", "" } } } },
+		{ "No quotes around value with commas", { "Hello_World,Salut, world,", { { "Hello_World", "Salut", " world", "" } } } },
+		{ "Quotes around value with newline", { "Hello_World,\"Salut,\n world\",", { { "Hello_World", "Salut,\n world", "" } } } },
+		{ "Escaped quotes", { "Hello_World,\"She said \"\"Hi\"\"\",", { { "Hello_World", "She said \"Hi\"", "" } } } },
+		{ "CRLF rows", { "A,1\r\nB,2\r\n", { { "A", "1" }, { "B", "2" } } } },
+		{ "Blank line", { "A,1\n\nB,2", { { "A", "1" }, { "" }, { "B", "2" } } } },
+	};
+
+	for ( const auto& Pair : Data )
+	{
+		FString Buffer = Pair.Value.Input;
+		FBYGCSVParser Parser( Buffer );
+		FBYGCSVParser::FRow Row;
+
+		int32 RowIndex = 0;
+		while ( Parser.ParseRow( Row ) )
+		{
+			if ( !TestTrue( Pair.Key + " row count", Pair.Value.ExpectedRows.IsValidIndex( RowIndex ) ) )
+				break;
+			const TArray<FString>& ExpectedRow = Pair.Value.ExpectedRows[ RowIndex ];
+			TestEqual( Pair.Key + " cell count", Row.Num(), ExpectedRow.Num() );
+			for ( int32 i = 0; i < FMath::Min( Row.Num(), ExpectedRow.Num() ); ++i )
+			{
+				TestEqual( Pair.Key, FBYGCSVParser::ToString( Row[ i ] ), ExpectedRow[ i ] );
+			}
+			++RowIndex;
+		}
+		TestEqual( Pair.Key + " rows", RowIndex, Pair.Value.ExpectedRows.Num() );
+
+		// Parsing the UTF-8 bytes must give the same cells
+		const FTCHARToUTF8 Converted( *Pair.Value.Input, Pair.Value.Input.Len() );
+		TArray<ANSICHAR> UTF8Buffer( Converted.Get(), Converted.Length() );
+		FBYGUTF8CSVParser UTF8Parser( UTF8Buffer.GetData(), UTF8Buffer.Num() );
+		FBYGUTF8CSVParser::FRow UTF8Row;
+		RowIndex = 0;
+		while ( UTF8Parser.ParseRow( UTF8Row ) )
+		{
+			if ( !TestTrue( Pair.Key + " UTF-8 row count", Pair.Value.ExpectedRows.IsValidIndex( RowIndex ) ) )
+				break;
+			const TArray<FString>& ExpectedRow = Pair.Value.ExpectedRows[ RowIndex ];
+			TestEqual( Pair.Key + " UTF-8 cell count", UTF8Row.Num(), ExpectedRow.Num() );
+			for ( int32 i = 0; i < FMath::Min( UTF8Row.Num(), ExpectedRow.Num() ); ++i )
+			{
+				TestEqual( Pair.Key + " UTF-8", FBYGUTF8CSVParser::ToString( UTF8Row[ i ] ), ExpectedRow[ i ] );
+			}
+			++RowIndex;
+		}
+		TestEqual( Pair.Key + " UTF-8 rows", RowIndex, Pair.Value.ExpectedRows.Num() );
+	}
+
+	// Line numbers should count newlines inside quoted cells
+	{
+		FString Buffer = "Key,SourceString\nA,\"one\ntwo\"\nB,three";
+		FBYGCSVParser Parser( Buffer );
+		FBYGCSVParser::FRow Row;
+		Parser.ParseRow( Row );
+		Parser.ParseRow( Row );
+		TestEqual( "Line number of multi-line row", Parser.GetLineNumber(), 2 );
+		Parser.ParseRow( Row );
+		TestEqual( "Line number after multi-line row", Parser.GetLineNumber(), 4 );
+	}
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGFileEncodingTest, FFunctionalTestBase, "BYG.Localization.FileEncoding", TestFlags )
+bool FBYGFileEncodingTest::RunTest( const FString& Parameters )
+{
+	// UTF-8 files are parsed as bytes, UTF-16 files are converted first. Both must give the same data and stats
+	const FString CSV = FString( "Key,SourceString,Comment,Primary,Status\r\n" )
+		+ TEXT( "Greeting,\"Caf\u00E9, s'il vous pla\u00EEt\",\u65E5\u672C,Coffee please,\r\n" )
+		+ TEXT( "Farewell,Au revoir,,Goodbye,New Entry\r\n" )
+		+ TEXT( "Menu,\"\"\"Carte\"\"\",,Menu,Modified Entry: was 'Men\u00FC'\r\n" )
+		+ TEXT( "Old,Vieux,,,Deprecated Entry\r\n" );
+
+	struct FData
+	{
+		const FFileHelper::EEncodingOptions Encoding;
+	};
+	const TMap<FString, FData> Data = {
+		{ "UTF-8", { FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM } },
+		{ "UTF-8 with byte order mark", { FFileHelper::EEncodingOptions::ForceUTF8 } },
+		{ "UTF-16", { FFileHelper::EEncodingOptions::ForceUnicode } },
+	};
+
+	UBYGLocalization* Loc = new UBYGLocalization();
+	Loc->Construct( MakeShared<UBYGLocalizationSettingsProvider>() );
+
+	for ( const auto& Pair : Data )
+	{
+		const FString Path = FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGLocalizationTest" ), TEXT( ".csv" ) );
+		TestTrue( Pair.Key + " write", FFileHelper::SaveStringToFile( CSV, *Path, Pair.Value.Encoding ) );
+
+		FBYGLocaleData LocaleData;
+		TestTrue( Pair.Key + " load", Loc->GetLocalizationDataFromFile( Path, LocaleData ) );
+		TestEqual( Pair.Key + " entries", LocaleData.Num(), 4 );
+		if ( LocaleData.Num() == 4 )
+		{
+			TestEqual( Pair.Key + " key", FString( LocaleData.GetKey( 0 ) ), FString( "Greeting" ) );
+			TestEqual( Pair.Key + " quoted translation", FString( LocaleData.GetTranslation( 0 ) ), FString( TEXT( "Caf\u00E9, s'il vous pla\u00EEt" ) ) );
+			TestEqual( Pair.Key + " comment", FString( LocaleData.GetComment( 0 ) ), FString( TEXT( "\u65E5\u672C" ) ) );
+			TestEqual( Pair.Key + " escaped quotes", FString( LocaleData.GetTranslation( 2 ) ), FString( "\"Carte\"" ) );
+			TestEqual( Pair.Key + " new", LocaleData.GetStatus( 1 ), EBYGLocEntryStatus::New );
+			TestEqual( Pair.Key + " modified", LocaleData.GetStatus( 2 ), EBYGLocEntryStatus::Modified );
+			TestEqual( Pair.Key + " old primary", FString( LocaleData.GetOldPrimary( 2 ) ), FString( TEXT( "Men\u00FC" ) ) );
+			TestEqual( Pair.Key + " deprecated", LocaleData.GetStatus( 3 ), EBYGLocEntryStatus::Deprecated );
+		}
+		TestEqual( Pair.Key + " find", LocaleData.FindIndex( TEXT( "Farewell" ) ), 1 );
+
+		BYGLocStats Stats;
+		TestTrue( Pair.Key + " stats", Loc->GetLocalizationStats( Path, Stats ) );
+		TestEqual( Pair.Key + " no status", Stats[ EBYGLocEntryStatus::None ], 1 );
+		TestEqual( Pair.Key + " new status", Stats[ EBYGLocEntryStatus::New ], 1 );
+		TestEqual( Pair.Key + " modified status", Stats[ EBYGLocEntryStatus::Modified ], 1 );
+		TestEqual( Pair.Key + " deprecated status", Stats[ EBYGLocEntryStatus::Deprecated ], 1 );
+
+		IFileManager::Get().Delete( *Path );
+	}
+
+	delete Loc;
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGStatsTest, FFunctionalTestBase, "BYG.Localization.Stats", TestFlags )
+bool FBYGStatsTest::RunTest( const FString& Parameters )
+{
+	UBYGLocalizationSettings* Settings = NewObject<UBYGLocalizationSettings>();
+
+	// The matcher on its own, for both TCHAR and UTF-8 cells
+	{
+		const FBYGStatusMatcher Matcher( *Settings );
+		struct FData
+		{
+			const FString Status;
+			const EBYGLocEntryStatus Expected;
+		};
+		const TMap<FString, FData> Data = {
+			{ "Empty", { "", EBYGLocEntryStatus::None } },
+			{ "Exact", { Settings->NewStatus, EBYGLocEntryStatus::New } },
+			{ "Lower case", { Settings->NewStatus.ToLower(), EBYGLocEntryStatus::New } },
+			{ "Upper case", { Settings->DeprecatedStatus.ToUpper(), EBYGLocEntryStatus::Deprecated } },
+			{ "Prefix with suffix", { Settings->ModifiedStatusLeft + "Old" + Settings->ModifiedStatusRight, EBYGLocEntryStatus::Modified } },
+			{ "Shorter than prefix", { Settings->NewStatus.LeftChop( 1 ), EBYGLocEntryStatus::None } },
+			{ "Leading space", { " " + Settings->NewStatus, EBYGLocEntryStatus::None } },
+			{ "Unknown", { "Something else", EBYGLocEntryStatus::None } },
+		};
+		for ( const auto& Pair : Data )
+		{
+			TestEqual( Pair.Key, Matcher.Classify( FStringView( Pair.Value.Status ) ), Pair.Value.Expected );
+			const FTCHARToUTF8 Converted( *Pair.Value.Status, Pair.Value.Status.Len() );
+			TestEqual( Pair.Key + " UTF-8", Matcher.Classify( TStringView<ANSICHAR>( Converted.Get(), Converted.Length() ) ), Pair.Value.Expected );
+		}
+	}
+
+	// Only the Status column is looked at. Quoted cells before it must not shift the columns, rows that are too
+	// short to have a status are not counted, and text that looks like a status in another column is ignored
+	const FString CSV = FString( "Key,SourceString,Comment,Primary,Status\n" )
+		+ "Plain,Bonjour,,Hello,\n"
+		+ "Quoted,\"Salut, \"\"world\"\"\",\"A comment,\nover two lines\",\"Hi,\nthere\"," + Settings->NewStatus.ToLower() + "\n"
+		+ "Modified,Salut,,Hi," + Settings->ModifiedStatusLeft + "Hello" + Settings->ModifiedStatusRight + "\n"
+		+ "Deprecated,Vieux,,," + Settings->DeprecatedStatus.ToUpper() + "\n"
+		+ "Decoy," + Settings->DeprecatedStatus + "," + Settings->NewStatus + ",,\n"
+		+ "Short,Court," + Settings->NewStatus + "\n"
+		+ "Unknown,Inconnu,,,Something else";
+
+	UBYGLocalization* Loc = new UBYGLocalization();
+	Loc->Construct( MakeShared<UBYGLocalizationSettingsTestProvider>( Settings ) );
+
+	const FString Path = FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGLocalizationTest" ), TEXT( ".csv" ) );
+	TestTrue( "Write", FFileHelper::SaveStringToFile( CSV, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM ) );
+
+	BYGLocStats Stats;
+	TestTrue( "Stats", Loc->GetLocalizationStats( Path, Stats ) );
+	TestEqual( "No status", Stats[ EBYGLocEntryStatus::None ], 3 );
+	TestEqual( "New", Stats[ EBYGLocEntryStatus::New ], 1 );
+	TestEqual( "Modified", Stats[ EBYGLocEntryStatus::Modified ], 1 );
+	TestEqual( "Deprecated", Stats[ EBYGLocEntryStatus::Deprecated ], 1 );
+
+	// Must agree with the full parse
+	FBYGLocaleData LocaleData;
+	TestTrue( "Full parse", Loc->GetLocalizationDataFromFile( Path, LocaleData ) );
+	BYGLocStats ParsedStats;
+	for ( int32 i = 0; i < LocaleData.Num(); ++i )
+	{
+		ParsedStats[ LocaleData.GetStatus( i ) ] += 1;
+	}
+	TestEqual( "Full parse new", ParsedStats[ EBYGLocEntryStatus::New ], Stats[ EBYGLocEntryStatus::New ] );
+	TestEqual( "Full parse modified", ParsedStats[ EBYGLocEntryStatus::Modified ], Stats[ EBYGLocEntryStatus::Modified ] );
+	TestEqual( "Full parse deprecated", ParsedStats[ EBYGLocEntryStatus::Deprecated ], Stats[ EBYGLocEntryStatus::Deprecated ] );
+
+	// Cancelling stops the scan, it is only checked every 1024 rows
+	{
+		FString Big = "Key,SourceString,Comment,Primary,Status\n";
+		for ( int32 i = 0; i < 2048; ++i )
+		{
+			Big += FString::Printf( TEXT( "Key_%d,Text,,Text,\n" ), i );
+		}
+		TestTrue( "Write big", FFileHelper::SaveStringToFile( Big, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM ) );
+		const FThreadSafeBool bCancelled( true );
+		TestFalse( "Cancelled", Loc->GetLocalizationStats( Path, Stats, &bCancelled ) );
+	}
+
+	IFileManager::Get().Delete( *Path );
+	delete Loc;
+
+	return true;
+}
+
+
 IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGEscapeCharacterTest, FFunctionalTestBase, "BYG.Localization.EscapeCharacter", TestFlags )
 bool FBYGEscapeCharacterTest::RunTest( const FString& Parameters )
 {
@@ -208,7 +436,7 @@ bool FBYGWriteCSVTest::RunTest( const FString& Parameters )
 		UBYGLocalization* Loc = new UBYGLocalization();
 		TSharedRef<IBYGLocalizationSettingsProvider> Provider;
 		Loc->Construct( Provider );
-		const bool bSuccess = Loc->WriteCSV( Pair.Value.Entries, FilenameWithPath );
+		const bool bSuccess = Loc->WriteCSV( FBYGLocaleData( Pair.Value.Entries ), FilenameWithPath );
 		TestTrue( Pair.Key + " file write " + FilenameWithPath, bSuccess );
 
 		FString Output;
@@ -220,11 +448,97 @@ bool FBYGWriteCSVTest::RunTest( const FString& Parameters )
 		delete Loc;
 	}
 
+	// A locale file that is already up to date is left alone, using the hash from when the update loaded it
+	const FString Header = "Key,SourceString,Comment,Primary,Status\r\n";
+	const FBYGTestLocalizationDirectory Directory;
+	Directory.Settings->bIncrementalUpdate = false;
+	Directory.Write( TEXT( "en" ), Header + "A,Apple,,,\r\n" );
+	Directory.Write( TEXT( "fr" ), Header + "A,Pomme,,Apple,\r\n" );
+
+	UBYGLocalization* Loc = new UBYGLocalization();
+	Loc->Construct( MakeShared<UBYGLocalizationSettingsTestProvider>( Directory.Settings ) );
+	TestTrue( "First update", Loc->UpdateTranslations() );
+
+	const FString Path = Directory.GetPath( TEXT( "fr" ) );
+	const FString UpToDate = Directory.Read( TEXT( "fr" ) );
+	const FDateTime OldTimestamp( 2001, 1, 1 );
+	TestTrue( "Set timestamp", IFileManager::Get().SetTimeStamp( *Path, OldTimestamp ) );
+
+	TestTrue( "Second update", Loc->UpdateTranslations() );
+	const TArray<FBYGUpdateFileResult>& Files = Loc->GetLastUpdateReport().Files;
+	if ( TestTrue( "Locale merged", Files.Num() == 1 ) )
+	{
+		TestFalse( "Unchanged file not written", Files[ 0 ].bWritten );
+	}
+	TestTrue( "Unchanged file keeps its timestamp", IFileManager::Get().GetTimeStamp( *Path ) == OldTimestamp );
+	TestEqual( "Unchanged file keeps its contents", Directory.Read( TEXT( "fr" ) ), UpToDate );
+
+	delete Loc;
+
 	return true;
 }
 
 
 
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGReplaceFileTest, FFunctionalTestBase, "BYG.Localization.ReplaceFile", TestFlags )
+bool FBYGReplaceFileTest::RunTest( const FString& Parameters )
+{
+	FBYGTestLocalizationDirectory Dir;
+	const FString Path = Dir.GetPath( "fr" );
+	const FString BackupPath = Path + TEXT( ".bak" );
+	const FString TempPath = Path + TEXT( ".tmp" );
+	IFileManager& FileManager = IFileManager::Get();
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	auto Replace = []( const FString& Filename, const char* Contents, bool bCreateBackup )
+	{
+		return UBYGLocalization::ReplaceFile( Filename, TArrayView<const uint8>( reinterpret_cast<const uint8*>( Contents ), FCStringAnsi::Strlen( Contents ) ), bCreateBackup );
+	};
+	auto Read = []( const FString& Filename )
+	{
+		FString Contents;
+		FFileHelper::LoadFileToString( Contents, *Filename );
+		return Contents;
+	};
+
+	// Nothing to back up yet
+	TestTrue( "Write new file", Replace( Path, "Old", true ) );
+	TestEqual( "New file contents", Read( Path ), FString( "Old" ) );
+	TestFalse( "No backup of a new file", FileManager.FileExists( *BackupPath ) );
+	TestFalse( "No temp file left", FileManager.FileExists( *TempPath ) );
+
+	TestTrue( "Replace with backup", Replace( Path, "New", true ) );
+	TestEqual( "Replaced contents", Read( Path ), FString( "New" ) );
+	TestEqual( "Backup has the old contents", Read( BackupPath ), FString( "Old" ) );
+	TestFalse( "No temp file left after replacing", FileManager.FileExists( *TempPath ) );
+
+	// The old backup is replaced, and the new one keeps its contents after the file it was linked to is replaced
+	TestTrue( "Replace over backup", Replace( Path, "Newest", true ) );
+	TestEqual( "Replaced over backup contents", Read( Path ), FString( "Newest" ) );
+	TestEqual( "Backup has the previous contents", Read( BackupPath ), FString( "New" ) );
+
+	FileManager.Delete( *BackupPath );
+	TestTrue( "Replace without backup", Replace( Path, "Newer", false ) );
+	TestEqual( "Replaced contents without backup", Read( Path ), FString( "Newer" ) );
+	TestFalse( "No backup", FileManager.FileExists( *BackupPath ) );
+
+	// Whether read-only files should be updated is decided by the caller
+	PlatformFile.SetReadOnly( *Path, true );
+	TestTrue( "Replace read-only file", Replace( Path, "ReadOnly", false ) );
+	TestEqual( "Replaced read-only contents", Read( Path ), FString( "ReadOnly" ) );
+	PlatformFile.SetReadOnly( *Path, false );
+
+	// A rename that fails leaves the destination alone and cleans up after itself
+	const FString DirectoryPath = Dir.GetPath( "de" );
+	TestTrue( "Make directory", FileManager.MakeDirectory( *DirectoryPath, true ) );
+	AddExpectedError( TEXT( "Unable to move" ), EAutomationExpectedErrorFlags::Contains, 1 );
+	TestFalse( "Can't replace a directory", Replace( DirectoryPath, "Nope", false ) );
+	TestTrue( "Directory left alone", FileManager.DirectoryExists( *DirectoryPath ) );
+	TestFalse( "No temp file left after failing", FileManager.FileExists( *( DirectoryPath + TEXT( ".tmp" ) ) ) );
+
+	return true;
+}
+
 IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGFullLoopTest, FFunctionalTestBase, "BYG.Localization.FullLoop", TestFlags )
 bool FBYGFullLoopTest::RunTest( const FString& Parameters )
 {
@@ -233,12 +547,9 @@ bool FBYGFullLoopTest::RunTest( const FString& Parameters )
 		const FString Input;
 	};
 
-	const TArray<FBYGLocalizationEntry> PrimaryEntries = {
+	const FBYGLocaleData PrimaryData( TArray<FBYGLocalizationEntry>{
 		{ "FirstKey", "Hello", "" }
-	};
-	const TMap<FString, int32> PrimaryKeyToIndex = {
-		{ "FirstKey", 0 },
-	};
+	} );
 
 	// TODO test this with the force and lazy quote system
 	// TODO newline \r\n may cause platform issues?
@@ -269,7 +580,7 @@ bool FBYGFullLoopTest::RunTest( const FString& Parameters )
 
 		for ( int32 i = 0; i < LoopCount; ++i )
 		{
-			const bool bSuccess = Loc->UpdateTranslationFile( FilenameWithPath, &PrimaryEntries, &PrimaryKeyToIndex );
+			const bool bSuccess = Loc->UpdateTranslationFile( FilenameWithPath, PrimaryData );
 			TestTrue( Pair.Key + " file write " + FilenameWithPath, bSuccess );
 
 			FString Output;
@@ -285,5 +596,1033 @@ bool FBYGFullLoopTest::RunTest( const FString& Parameters )
 }
 
 
-#endif
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGPrimaryDeltaTest, FFunctionalTestBase, "BYG.Localization.PrimaryDelta", TestFlags )
+bool FBYGPrimaryDeltaTest::RunTest( const FString& Parameters )
+{
+	// Applying the delta must give exactly the same file as a full merge
+	const FString Header = "Key,SourceString,Comment,Primary,Status\r\n";
+	const FString OldPrimaryCSV = Header + "A,Apple,,,\r\nB,Banana,,,\r\nC,Cherry,,,\r\nD,Date,,,\r\n";
+	const FString LocaleCSV = Header + "A,Pomme,,Apple,\r\nB,Banane,,Banana,\r\nC,Cerise,,Cherry,\r\nD,Datte,,Date,\r\n";
+
+	struct FData
+	{
+		const FString NewPrimaryCSV;
+	};
+	const TMap<FString, FData> Data = {
+		{ "Unchanged", { Header + "A,Apple,,,\r\nB,Banana,,,\r\nC,Cherry,,,\r\nD,Date,,,\r\n" } },
+		{ "Modified", { Header + "A,Apple,,,\r\nB,Big banana,,,\r\nC,Cherry,,,\r\nD,Date,,,\r\n" } },
+		{ "Added", { Header + "A,Apple,,,\r\nE,Elderberry,,,\r\nB,Banana,,,\r\nC,Cherry,,,\r\nD,Date,,,\r\n" } },
+		{ "Removed", { Header + "A,Apple,,,\r\nC,Cherry,,,\r\nD,Date,,,\r\n" } },
+		{ "Reordered", { Header + "D,Date,,,\r\nC,Cherry,,,\r\nB,Banana,,,\r\nA,Apple,,,\r\n" } },
+		{ "Everything", { Header + "D,Dried date,,,\r\nE,Elderberry,,,\r\nA,Apple,,,\r\n" } },
+	};
+
+	UBYGLocalization* Loc = new UBYGLocalization();
+	Loc->Construct( MakeShared<UBYGLocalizationSettingsProvider>() );
+
+	auto LoadData = [&]( const FString& CSV, FBYGLocaleData& OutData )
+	{
+		const FString Path = FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGLocalizationTest" ), TEXT( ".csv" ) );
+		FFileHelper::SaveStringToFile( CSV, *Path );
+		const bool bLoaded = Loc->GetLocalizationDataFromFile( Path, OutData );
+		IFileManager::Get().Delete( *Path );
+		return bLoaded;
+	};
+
+	FBYGLocaleData OldPrimaryData;
+	TestTrue( "Load old primary", LoadData( OldPrimaryCSV, OldPrimaryData ) );
+
+	for ( const auto& Pair : Data )
+	{
+		FBYGLocaleData NewPrimaryData;
+		TestTrue( Pair.Key + " load new primary", LoadData( Pair.Value.NewPrimaryCSV, NewPrimaryData ) );
+
+		FBYGPrimaryDelta Delta;
+		TestTrue( Pair.Key + " compute delta", UBYGLocalization::ComputePrimaryDelta( OldPrimaryData, NewPrimaryData, Delta ) );
+
+		const FString FullPath = FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGLocalizationTest" ), TEXT( ".csv" ) );
+		const FString DeltaPath = FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGLocalizationTest" ), TEXT( ".csv" ) );
+		FFileHelper::SaveStringToFile( LocaleCSV, *FullPath );
+		FFileHelper::SaveStringToFile( LocaleCSV, *DeltaPath );
+
+		FBYGUpdateFileResult FullResult;
+		FBYGUpdateFileResult DeltaResult;
+		Loc->UpdateTranslationFile( FullPath, NewPrimaryData, &FullResult );
+		Loc->UpdateTranslationFile( DeltaPath, NewPrimaryData, &DeltaResult, &Delta );
+
+		FString FullOutput;
+		FString DeltaOutput;
+		FFileHelper::LoadFileToString( FullOutput, *FullPath );
+		FFileHelper::LoadFileToString( DeltaOutput, *DeltaPath );
+		TestEqual( Pair.Key + " file contents", DeltaOutput, FullOutput );
+		TestEqual( Pair.Key + " warnings", FString::Join( DeltaResult.Warnings, TEXT( "\n" ) ), FString::Join( FullResult.Warnings, TEXT( "\n" ) ) );
+		for ( int32 Status = 0; Status < BYGLocStats::NumStatuses; ++Status )
+		{
+			TestEqual( FString::Printf( TEXT( "%s changed keys with status %d" ), *Pair.Key, Status ),
+				FString::Join( DeltaResult.ChangedKeys[ Status ], TEXT( "," ) ), FString::Join( FullResult.ChangedKeys[ Status ], TEXT( "," ) ) );
+		}
+
+		IFileManager::Get().Delete( *FullPath );
+		IFileManager::Get().Delete( *DeltaPath );
+	}
+
+	delete Loc;
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGUpdateReportTest, FFunctionalTestBase, "BYG.Localization.UpdateReport", TestFlags )
+bool FBYGUpdateReportTest::RunTest( const FString& Parameters )
+{
+	const FBYGLocaleData PrimaryData( TArray<FBYGLocalizationEntry>{
+		{ "A", "Apple", "" },
+		{ "B", "Big banana", "" },
+		{ "E", "Elderberry", "" },
+	} );
+	const FString LocaleCSV = "Key,SourceString,Comment,Primary,Status\r\nA,Pomme,,Apple,\r\nB,Banane,,Banana,\r\nC,Cerise,,Cherry,\r\n";
+
+	UBYGLocalization* Loc = new UBYGLocalization();
+	Loc->Construct( MakeShared<UBYGLocalizationSettingsProvider>() );
+
+	const FString Path = FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGLocalizationTest" ), TEXT( ".csv" ) );
+	FFileHelper::SaveStringToFile( LocaleCSV, *Path );
+
+	FBYGUpdateReport Report;
+	FBYGUpdateFileResult& Result = Report.Files.AddDefaulted_GetRef();
+	Loc->UpdateTranslationFile( Path, PrimaryData, &Result );
+	IFileManager::Get().Delete( *Path );
+
+	// Changed keys go in the report, not the warnings
+	TestEqual( "Warnings", Result.Warnings.Num(), 0 );
+	TestEqual( "Added keys", FString::Join( Result.GetChangedKeys( EBYGLocEntryStatus::New ), TEXT( "," ) ), FString( "E" ) );
+	TestEqual( "Modified keys", FString::Join( Result.GetChangedKeys( EBYGLocEntryStatus::Modified ), TEXT( "," ) ), FString( "B" ) );
+	TestEqual( "Deprecated keys", FString::Join( Result.GetChangedKeys( EBYGLocEntryStatus::Deprecated ), TEXT( "," ) ), FString( "C" ) );
+	TestEqual( "Unchanged keys", Result.GetChangedKeys( EBYGLocEntryStatus::None ).Num(), 0 );
+	TestEqual( "Number of changed keys", Result.GetNumChangedKeys(), 3 );
+
+	const FString CSVPath = FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGLocalizationTest" ), TEXT( ".csv" ) );
+	TestTrue( "Save CSV report", Report.Save( CSVPath, EBYGUpdateReportFormat::CSV ) );
+	FString CSVReport;
+	FFileHelper::LoadFileToString( CSVReport, *CSVPath );
+	TArray<FString> Lines;
+	CSVReport.ParseIntoArrayLines( Lines );
+	TestEqual( "CSV report lines", Lines.Num(), 4 );
+	if ( Lines.Num() == 4 )
+	{
+		TestEqual( "CSV report header", Lines[ 0 ], FString( "Locale,Path,Status,Key" ) );
+		TestTrue( "CSV report added key", Lines[ 1 ].EndsWith( TEXT( ",New,E" ) ) );
+		TestTrue( "CSV report modified key", Lines[ 2 ].EndsWith( TEXT( ",Modified,B" ) ) );
+		TestTrue( "CSV report deprecated key", Lines[ 3 ].EndsWith( TEXT( ",Deprecated,C" ) ) );
+	}
+	IFileManager::Get().Delete( *CSVPath );
+
+	const FString JsonPath = FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGLocalizationTest" ), TEXT( ".json" ) );
+	TestTrue( "Save JSON report", Report.Save( JsonPath, EBYGUpdateReportFormat::JSON ) );
+	FString JsonReport;
+	FFileHelper::LoadFileToString( JsonReport, *JsonPath );
+	TSharedPtr<FJsonObject> Root;
+	TestTrue( "Read JSON report", FJsonSerializer::Deserialize( TJsonReaderFactory<>::Create( JsonReport ), Root ) && Root.IsValid() );
+	if ( Root.IsValid() )
+	{
+		const TArray<TSharedPtr<FJsonValue>>& JsonFiles = Root->GetArrayField( TEXT( "Files" ) );
+		TestEqual( "JSON report files", JsonFiles.Num(), 1 );
+		if ( JsonFiles.Num() == 1 )
+		{
+			const TSharedPtr<FJsonObject> JsonFile = JsonFiles[ 0 ]->AsObject();
+			TestEqual( "JSON report locale", JsonFile->GetStringField( TEXT( "Locale" ) ), Result.Culture );
+			TestEqual( "JSON report modified count", static_cast<int32>( JsonFile->GetObjectField( TEXT( "Counts" ) )->GetNumberField( TEXT( "Modified" ) ) ), 1 );
+			TestEqual( "JSON report deprecated keys", JsonFile->GetObjectField( TEXT( "Keys" ) )->GetArrayField( TEXT( "Deprecated" ) ).Num(), 1 );
+		}
+	}
+	IFileManager::Get().Delete( *JsonPath );
+
+	delete Loc;
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGParallelUpdateTest, FFunctionalTestBase, "BYG.Localization.ParallelUpdate", TestFlags )
+bool FBYGParallelUpdateTest::RunTest( const FString& Parameters )
+{
+	// Updating files on worker threads must give the same files and the same report as updating them one-by-one
+	static const TCHAR* LocaleCodes[] = { TEXT( "fr" ), TEXT( "de" ), TEXT( "es" ), TEXT( "it" ), TEXT( "ja" ), TEXT( "ko" ), TEXT( "pt" ), TEXT( "ru" ) };
+	const int32 NumKeys = 64;
+	const FString Header = "Key,SourceString,Comment,Primary,Status\r\n";
+
+	FString PrimaryCSV = Header;
+	for ( int32 Key = 0; Key < NumKeys; ++Key )
+	{
+		PrimaryCSV += FString::Printf( TEXT( "Key_%d,\"Text %d, primary\",,,\r\n" ), Key, Key );
+	}
+
+	// Each locale is missing a different key, has an out of date primary and has a key the primary doesn't, and
+	// they are different sizes so they get scheduled in a different order to how they were found
+	TMap<FString, FString> LocaleCSVs;
+	for ( int32 i = 0; i < static_cast<int32>( UE_ARRAY_COUNT( LocaleCodes ) ); ++i )
+	{
+		FString CSV = Header;
+		for ( int32 Key = 0; Key < NumKeys - i * 4; ++Key )
+		{
+			if ( Key == i )
+				continue;
+			const FString Primary = Key == i + 1 ? FString( "Old text" ) : FString::Printf( TEXT( "Text %d, primary" ), Key );
+			CSV += FString::Printf( TEXT( "Key_%d,\"[%s] %d\",,\"%s\",\r\n" ), Key, LocaleCodes[ i ], Key, *Primary );
+		}
+		CSV += FString::Printf( TEXT( "Stale_%s,Gone,,Gone,\r\n" ), LocaleCodes[ i ] );
+		LocaleCSVs.Add( LocaleCodes[ i ], CSV );
+	}
+
+	const FBYGTestLocalizationDirectory Parallel;
+	const FBYGTestLocalizationDirectory Serial;
+	Parallel.Settings->bParallelUpdate = true;
+	Serial.Settings->bParallelUpdate = false;
+
+	TMap<FString, FBYGUpdateFileResult> Results[ 2 ];
+	const FBYGTestLocalizationDirectory* Directories[ 2 ] = { &Parallel, &Serial };
+	for ( int32 d = 0; d < 2; ++d )
+	{
+		const FBYGTestLocalizationDirectory& Directory = *Directories[ d ];
+		const FString Name = Directory.Settings->bParallelUpdate ? "Parallel" : "Serial";
+		Directory.Settings->bIncrementalUpdate = false;
+		Directory.Write( TEXT( "en" ), PrimaryCSV );
+		for ( const auto& Pair : LocaleCSVs )
+		{
+			Directory.Write( Pair.Key, Pair.Value );
+		}
+
+		UBYGLocalization* Loc = new UBYGLocalization();
+		Loc->Construct( MakeShared<UBYGLocalizationSettingsTestProvider>( Directory.Settings ) );
+		TestTrue( Name + " update", Loc->UpdateTranslations() );
+
+		// Results are reported in the order files were found, not the order they finished in
+		TArray<FString> FoundFiles = *Loc->GetLocalizationFilesSnapshot();
+		FoundFiles.RemoveAll( []( const FString& File ) { return FPaths::GetBaseFilename( File ) == TEXT( "loc_en" ); } );
+		const TArray<FBYGUpdateFileResult>& Files = Loc->GetLastUpdateReport().Files;
+		TestEqual( Name + " report has every locale", Files.Num(), FoundFiles.Num() );
+		for ( int32 i = 0; i < FMath::Min( Files.Num(), FoundFiles.Num() ); ++i )
+		{
+			TestEqual( Name + " report order", FPaths::GetCleanFilename( Files[ i ].Path ), FPaths::GetCleanFilename( FoundFiles[ i ] ) );
+			Results[ d ].Add( Files[ i ].Culture, Files[ i ] );
+		}
+		delete Loc;
+	}
+
+	for ( const auto& Pair : LocaleCSVs )
+	{
+		const FString ParallelCSV = Parallel.Read( Pair.Key );
+		TestNotEqual( Pair.Key + " updated", ParallelCSV, Pair.Value );
+		TestEqual( Pair.Key + " same output", ParallelCSV, Serial.Read( Pair.Key ) );
+
+		const FBYGUpdateFileResult* ParallelResult = Results[ 0 ].Find( Pair.Key );
+		const FBYGUpdateFileResult* SerialResult = Results[ 1 ].Find( Pair.Key );
+		if ( !TestTrue( Pair.Key + " reported", ParallelResult && SerialResult ) )
+			continue;
+		TestTrue( Pair.Key + " changes found", ParallelResult->GetNumChangedKeys() > 0 );
+		for ( int32 Status = 0; Status < BYGLocStats::NumStatuses; ++Status )
+		{
+			TestEqual( Pair.Key + " same changed keys", FString::Join( ParallelResult->ChangedKeys[ Status ], TEXT( "," ) ), FString::Join( SerialResult->ChangedKeys[ Status ], TEXT( "," ) ) );
+		}
+		TestTrue( Pair.Key + " same hash", ParallelResult->Hash == SerialResult->Hash );
+	}
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGIncrementalUpdateTest, FFunctionalTestBase, "BYG.Localization.IncrementalUpdate", TestFlags )
+bool FBYGIncrementalUpdateTest::RunTest( const FString& Parameters )
+{
+	const FString Header = "Key,SourceString,Comment,Primary,Status\r\n";
+	const FBYGTestLocalizationDirectory Directory;
+	Directory.Settings->bIncrementalUpdate = true;
+	Directory.Write( TEXT( "en" ), Header + "A,Apple,,,\r\nB,Banana,,,\r\n" );
+	Directory.Write( TEXT( "fr" ), Header + "A,Pomme,,Apple,\r\n" );
+	Directory.Write( TEXT( "de" ), Header + "A,Apfel,,Apple,\r\n" );
+
+	UBYGLocalization* Loc = new UBYGLocalization();
+	Loc->Construct( MakeShared<UBYGLocalizationSettingsTestProvider>( Directory.Settings ) );
+
+	auto GetUpdatedCultures = [Loc]()
+	{
+		TArray<FString> Cultures;
+		for ( const FBYGUpdateFileResult& Result : Loc->GetLastUpdateReport().Files )
+		{
+			Cultures.Add( Result.Culture );
+		}
+		Cultures.Sort();
+		return FString::Join( Cultures, TEXT( "," ) );
+	};
+
+	// Writes the manifest
+	TestTrue( "First update", Loc->UpdateTranslations() );
+	TestEqual( "First update merges every locale", GetUpdatedCultures(), FString( "de,fr" ) );
+
+	// Nothing changed, nothing is merged
+	TestTrue( "No-op update", Loc->UpdateTranslations() );
+	TestEqual( "No-op update merges nothing", GetUpdatedCultures(), FString() );
+
+	// A file with the same size and modification time is trusted without reading it. Changing a character and
+	// putting the timestamp back proves it wasn't hashed, a hash would have caught the change
+	IFileManager& FileManager = IFileManager::Get();
+	const FString FrenchPath = Directory.GetPath( TEXT( "fr" ) );
+	const FDateTime FrenchTimestamp = FileManager.GetTimeStamp( *FrenchPath );
+	TArray<uint8> FrenchBytes;
+	FFileHelper::LoadFileToArray( FrenchBytes, *FrenchPath );
+	const TArray<uint8> OriginalFrenchBytes = FrenchBytes;
+	for ( int32 i = 0; i + 4 < FrenchBytes.Num(); ++i )
+	{
+		if ( FMemory::Memcmp( &FrenchBytes[ i ], "Pomme", 5 ) == 0 )
+		{
+			FrenchBytes[ i + 4 ] = 'o';
+		}
+	}
+	FFileHelper::SaveArrayToFile( FrenchBytes, *FrenchPath );
+	FileManager.SetTimeStamp( *FrenchPath, FrenchTimestamp );
+	const FString Sneaky = Directory.Read( TEXT( "fr" ) );
+	TestTrue( "Changed a character", Sneaky.Contains( TEXT( "Pommo" ) ) );
+	TestTrue( "Same size and time update", Loc->UpdateTranslations() );
+	TestEqual( "Same size and time is not read", GetUpdatedCultures(), FString() );
+	TestEqual( "Same size and time is not rewritten", Directory.Read( TEXT( "fr" ) ), Sneaky );
+
+	// Touching a file makes us hash it, the contents are the same as we wrote so it is still skipped
+	FFileHelper::SaveArrayToFile( OriginalFrenchBytes, *FrenchPath );
+	FileManager.SetTimeStamp( *FrenchPath, FrenchTimestamp + FTimespan::FromMinutes( 1.0 ) );
+	TestTrue( "Touched update", Loc->UpdateTranslations() );
+	TestEqual( "Touched file with the same contents is skipped", GetUpdatedCultures(), FString() );
+
+	// The touched file's new modification time was saved even though nothing was merged, so it is trusted next time
+	const FDateTime TouchedTimestamp = FileManager.GetTimeStamp( *FrenchPath );
+	FFileHelper::SaveArrayToFile( FrenchBytes, *FrenchPath );
+	FileManager.SetTimeStamp( *FrenchPath, TouchedTimestamp );
+	TestTrue( "Touched again update", Loc->UpdateTranslations() );
+	TestEqual( "Touched file is not hashed again", GetUpdatedCultures(), FString() );
+	FFileHelper::SaveArrayToFile( OriginalFrenchBytes, *FrenchPath );
+	FileManager.SetTimeStamp( *FrenchPath, TouchedTimestamp );
+
+	// Only the file that changed is merged
+	const FString German = Directory.Read( TEXT( "de" ) ) + "C,Kirsche,,Cherry,\r\n";
+	Directory.Write( TEXT( "de" ), German );
+	TestTrue( "Single change update", Loc->UpdateTranslations() );
+	TestEqual( "Only the changed file is merged", GetUpdatedCultures(), FString( "de" ) );
+	TestNotEqual( "Changed file is rewritten", Directory.Read( TEXT( "de" ) ), German );
+
+	// Changing the primary merges everything again
+	Directory.Write( TEXT( "en" ), Header + "A,Apple,,,\r\nB,Banana,,,\r\nD,Date,,,\r\n" );
+	TestTrue( "Primary change update", Loc->UpdateTranslations() );
+	TestEqual( "Primary change merges every locale", GetUpdatedCultures(), FString( "de,fr" ) );
+
+	delete Loc;
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGUpdateAllocationsTest, FFunctionalTestBase, "BYG.Localization.UpdateAllocations", TestFlags )
+bool FBYGUpdateAllocationsTest::RunTest( const FString& Parameters )
+{
+	// Every string should be copied at most once per update, into a buffer that holds all of them. If anything were
+	// copied into its own string the number of allocations would grow with the number of entries
+	UBYGLocalization* Loc = new UBYGLocalization();
+	Loc->Construct( MakeShared<UBYGLocalizationSettingsProvider>() );
+
+	auto CountUpdateAllocations = [&]( const int32 NumEntries )
+	{
+		TArray<FBYGLocalizationEntry> PrimaryEntries;
+		FString LocaleCSV = "Key,SourceString,Comment,Primary,Status\r\n";
+		for ( int32 i = 0; i < NumEntries; ++i )
+		{
+			const FString Key = FString::Printf( TEXT( "Key_%d" ), i );
+			const FString Text = FString::Printf( TEXT( "Text number %d, with a comma" ), i );
+			PrimaryEntries.Add( { Key, Text, "" } );
+			LocaleCSV += FString::Printf( TEXT( "%s,\"Texte numero %d\",\"A comment\",\"%s\",\r\n" ), *Key, i, *Text );
+		}
+		const FBYGLocaleData PrimaryData( PrimaryEntries );
+
+		const FString Path = FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGLocalizationTest" ), TEXT( ".csv" ) );
+		FFileHelper::SaveStringToFile( LocaleCSV, *Path );
 
+		// The first update writes the file out in our own format, the second has nothing to change
+		Loc->UpdateTranslationFile( Path, PrimaryData );
+
+		FBYGUpdateFileResult Result;
+		int32 NumAllocations = 0;
+		{
+			FBYGCountingMalloc CountingMalloc;
+			Loc->UpdateTranslationFile( Path, PrimaryData, &Result );
+			NumAllocations = CountingMalloc.GetNumAllocations();
+		}
+		TestTrue( FString::Printf( TEXT( "%d entries updated" ), NumEntries ), Result.bUpdated );
+		TestEqual( FString::Printf( TEXT( "%d entries warnings" ), NumEntries ), Result.Warnings.Num(), 0 );
+		TestEqual( FString::Printf( TEXT( "%d entries changed keys" ), NumEntries ), Result.GetNumChangedKeys(), 0 );
+
+		IFileManager::Get().Delete( *Path );
+		return NumAllocations;
+	};
+
+	const int32 SmallAllocations = CountUpdateAllocations( 1000 );
+	const int32 LargeAllocations = CountUpdateAllocations( 8000 );
+	AddInfo( FString::Printf( TEXT( "Update allocations: %d for 1000 entries, %d for 8000 entries" ), SmallAllocations, LargeAllocations ) );
+
+	// A little slack for engine file IO, which may not allocate the same for every file size
+	TestTrue( "Allocations don't depend on the number of entries", LargeAllocations <= SmallAllocations + 8 );
+	TestTrue( "Allocations are per buffer, not per entry", SmallAllocations < 100 );
+
+	delete Loc;
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGKeyIndexTest, FFunctionalTestBase, "BYG.Localization.KeyIndex", TestFlags )
+bool FBYGKeyIndexTest::RunTest( const FString& Parameters )
+{
+	TArray<FBYGLocalizationEntry> Entries;
+	const int32 NumKeys = 1000;
+	for ( int32 i = 0; i < NumKeys; ++i )
+	{
+		Entries.Add( { FString::Printf( TEXT( "Key_%d" ), i ), "Value", "" } );
+	}
+	// Keys are case-insensitive, so these are duplicates of entries 10 and 20
+	Entries.Add( { "KEY_10", "Duplicate", "" } );
+	Entries.Add( { "key_20", "Duplicate", "" } );
+
+	const FBYGLocaleData Data( Entries );
+
+	for ( int32 i = 0; i < NumKeys; ++i )
+	{
+		const FString Key = FString::Printf( TEXT( "Key_%d" ), i );
+		if ( Data.FindIndex( Key ) != i )
+		{
+			AddError( FString::Printf( TEXT( "Expected to find '%s' at %d, found %d" ), *Key, i, Data.FindIndex( Key ) ) );
+		}
+	}
+	TestEqual( "Case-insensitive lookup", Data.FindIndex( TEXT( "kEy_42" ) ), 42 );
+	TestEqual( "Missing key", Data.FindIndex( TEXT( "Key_1000" ) ), INDEX_NONE );
+	TestEqual( "Empty key", Data.FindIndex( TEXT( "" ) ), INDEX_NONE );
+	TestFalse( "Contains missing key", Data.Contains( TEXT( "Missing" ) ) );
+
+	TestTrue( "Has duplicates", Data.HasDuplicateKeys() );
+	TestEqual( "Duplicate count", Data.GetDuplicateIndices().Num(), 2 );
+	if ( Data.GetDuplicateIndices().Num() == 2 )
+	{
+		TestEqual( "First duplicate", Data.GetDuplicateIndices()[ 0 ], NumKeys );
+		TestEqual( "Second duplicate", Data.GetDuplicateIndices()[ 1 ], NumKeys + 1 );
+	}
+	// The first entry with a key wins
+	TestEqual( "Duplicate lookup", Data.FindIndex( TEXT( "Key_10" ) ), 10 );
+
+	const FBYGLocaleData Empty;
+	TestEqual( "Lookup in empty data", Empty.FindIndex( TEXT( "Key_0" ) ), INDEX_NONE );
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGLocaleDataTest, FFunctionalTestBase, "BYG.Localization.LocaleData", TestFlags )
+bool FBYGLocaleDataTest::RunTest( const FString& Parameters )
+{
+	// Views into the buffer the data owns are kept where they are
+	FString Buffer = TEXT( "GreetingHello" );
+	const TCHAR* BufferStart = *Buffer;
+	FBYGLocaleData Data( MoveTemp( Buffer ) );
+	Data.AddEntry( FStringView( BufferStart, 8 ), FStringView( BufferStart + 8, 5 ), FStringView(), FStringView(), FStringView(), EBYGLocEntryStatus::None );
+	TestTrue( "Key is not copied", Data.GetKey( 0 ).GetData() == BufferStart );
+
+	// Anything else is copied onto the end
+	const FString Farewell = TEXT( "Farewell" );
+	Data.AddEntry( Farewell, TEXT( "Goodbye" ), TEXT( "Said when leaving" ), TEXT( "Goodbye" ), TEXT( "Bye" ), EBYGLocEntryStatus::Modified );
+	TestTrue( "Key is copied", Data.GetKey( 1 ).GetData() != *Farewell );
+	Data.BuildIndex();
+
+	TestEqual( "Entries", Data.Num(), 2 );
+	TestEqual( "First key after append", FString( Data.GetKey( 0 ) ), FString( TEXT( "Greeting" ) ) );
+	TestEqual( "First translation", FString( Data.GetTranslation( 0 ) ), FString( TEXT( "Hello" ) ) );
+	TestEqual( "Lookup", Data.FindIndex( TEXT( "farewell" ) ), 1 );
+
+	const FBYGLocalizationEntry Entry = Data.GetEntry( 1 );
+	TestEqual( "Entry key", Entry.Key, Farewell );
+	TestEqual( "Entry comment", Entry.Comment, FString( TEXT( "Said when leaving" ) ) );
+	TestEqual( "Entry old primary", Entry.OldPrimary, FString( TEXT( "Bye" ) ) );
+	TestTrue( "Entry status", Entry.Status == EBYGLocEntryStatus::Modified );
+	TestEqual( "Chars", Data.GetNumChars(), 8 + 5 + 8 + 7 + 17 + 7 + 3 );
+
+	FBYGLocaleData Copy;
+	Copy.AddEntry( Data, 1, EBYGLocEntryStatus::Deprecated );
+	TestTrue( "Copied status", Copy.GetStatus( 0 ) == EBYGLocEntryStatus::Deprecated );
+	TestEqual( "Copied primary", FString( Copy.GetPrimary( 0 ) ), FString( TEXT( "Goodbye" ) ) );
+	TestTrue( "Copy has its own text", Copy.GetKey( 0 ).GetData() != Data.GetKey( 1 ).GetData() );
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGGameTextCacheTest, FFunctionalTestBase, "BYG.Localization.GameTextCache", TestFlags )
+bool FBYGGameTextCacheTest::RunTest( const FString& Parameters )
+{
+	const FName TableID( "BYGLocalizationTest_Current" );
+	const FName FallbackTableID( "BYGLocalizationTest_Fallback" );
+
+	FStringTableRef Table = FStringTable::NewStringTable();
+	Table->SetNamespace( "BYGLocalizationTest" );
+	Table->SetSourceString( "Greeting", "Salut" );
+	FStringTableRegistry::Get().RegisterStringTable( TableID, Table );
+
+	FStringTableRef FallbackTable = FStringTable::NewStringTable();
+	FallbackTable->SetNamespace( "BYGLocalizationTest" );
+	FallbackTable->SetSourceString( "Greeting", "Hello" );
+	FallbackTable->SetSourceString( "Farewell", "Goodbye" );
+	FStringTableRegistry::Get().RegisterStringTable( FallbackTableID, FallbackTable );
+
+	FBYGGameTextCache Cache( TableID, FallbackTableID );
+	const FString Greeting = "Greeting";
+	const FString Farewell = "Farewell";
+
+	// Keys only in the fallback table are logged once per cache, here and by GetGameText below
+	AddExpectedError( TEXT( "Could not find key 'Farewell'" ), EAutomationExpectedErrorFlags::Contains, 2 );
+
+	FText Text;
+	TestTrue( "Find key", Cache.Find( Greeting, Text ) );
+	TestEqual( "Key text", Text.ToString(), FString( "Salut" ) );
+	TestTrue( "Find fallback key", Cache.Find( Farewell, Text ) );
+	TestEqual( "Fallback key text", Text.ToString(), FString( "Goodbye" ) );
+	TestFalse( "Missing key", Cache.Find( "Missing", Text ) );
+	TestFalse( "Keys are case-sensitive", Cache.Find( "greeting", Text ) );
+
+	TArray<FText> Texts;
+	TBitArray<> Missing;
+	const int32 NumMissing = Cache.FindBatch( { Farewell, "Missing", Greeting }, Texts, Missing );
+	TestEqual( "Batch missing count", NumMissing, 1 );
+	TestEqual( "Batch text count", Texts.Num(), 3 );
+	TestEqual( "Batch missing bits", Missing.Num(), 3 );
+	if ( Texts.Num() == 3 && Missing.Num() == 3 )
+	{
+		TestEqual( "Batch fallback text", Texts[ 0 ].ToString(), FString( "Goodbye" ) );
+		TestEqual( "Batch text", Texts[ 2 ].ToString(), FString( "Salut" ) );
+		TestFalse( "Batch found bit", Missing[ 0 ] );
+		TestTrue( "Batch missing bit", Missing[ 1 ] );
+		TestFalse( "Batch found bit", Missing[ 2 ] );
+	}
+
+	// GetGameText uses the tables from settings, point them at ours for the rest of the test
+	UBYGLocalizationSettings* Settings = GetMutableDefault<UBYGLocalizationSettings>();
+	const FString OldStringtableID = Settings->StringtableID;
+	const FString OldPrimaryLanguageCode = Settings->PrimaryLanguageCode;
+	Settings->StringtableID = TableID.ToString();
+	Settings->PrimaryLanguageCode = FallbackTableID.ToString();
+	FBYGGameTextCache::Get().Reset();
+
+	TestEqual( "GetGameText", UBYGLocalizationStatics::GetGameText( Greeting ).ToString(), FString( "Salut" ) );
+	TestEqual( "GetGameText fallback", UBYGLocalizationStatics::GetGameText( Farewell ).ToString(), FString( "Goodbye" ) );
+
+	// Once a key has been looked up, looking it up again must not touch the heap
+	const int32 NumLookups = 10000;
+	int32 NumAllocations = 0;
+	double Seconds = 0.0;
+	{
+		FText FoundText;
+		FBYGCountingMalloc CountingMalloc;
+		const double StartTime = FPlatformTime::Seconds();
+		for ( int32 i = 0; i < NumLookups; ++i )
+		{
+			FoundText = UBYGLocalizationStatics::GetGameText( ( i & 1 ) ? Greeting : Farewell );
+		}
+		Seconds = FPlatformTime::Seconds() - StartTime;
+		NumAllocations = CountingMalloc.GetNumAllocations();
+	}
+	TestEqual( "Allocations for cached lookups", NumAllocations, 0 );
+	AddInfo( FString::Printf( TEXT( "%d cached lookups in %.3fms, %.1fns per lookup" ), NumLookups, Seconds * 1000.0, Seconds * 1e9 / NumLookups ) );
+
+	Settings->StringtableID = OldStringtableID;
+	Settings->PrimaryLanguageCode = OldPrimaryLanguageCode;
+	FBYGGameTextCache::Get().Reset();
+
+	FStringTableRegistry::Get().UnregisterStringTable( TableID );
+	FStringTableRegistry::Get().UnregisterStringTable( FallbackTableID );
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGStatsCacheTest, FFunctionalTestBase, "BYG.Localization.StatsCache", TestFlags )
+bool FBYGStatsCacheTest::RunTest( const FString& Parameters )
+{
+	UBYGLocalizationSettings* Settings = NewObject<UBYGLocalizationSettings>();
+	const FString CachePath = FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGStatsCacheTest" ), TEXT( ".json" ) );
+	const FString FilePath = TEXT( "C:/Project/Content/Localization/loc_fr.csv" );
+
+	FBYGStatsCache::FEntry Entry;
+	Entry.Size = 123456789;
+	Entry.Timestamp = FDateTime( 2021, 3, 4, 5, 6, 7, 8 );
+	// Larger than 2^53, so it would lose precision as a JSON number
+	Entry.Hash = 0xfedcba9876543210ull;
+	Entry.Stats[ EBYGLocEntryStatus::None ] = 10;
+	Entry.Stats[ EBYGLocEntryStatus::New ] = 2;
+	Entry.Stats[ EBYGLocEntryStatus::Modified ] = 3;
+	Entry.Stats[ EBYGLocEntryStatus::Deprecated ] = 4;
+
+	{
+		FBYGStatsCache Cache;
+		Cache.Load( CachePath, *Settings );
+		Cache.Add( FilePath, Entry );
+		TestTrue( "Save cache", Cache.Save( CachePath ) );
+	}
+
+	{
+		FBYGStatsCache Cache;
+		TestTrue( "Load cache", Cache.Load( CachePath, *Settings ) );
+		const FBYGStatsCache::FEntry* Found = Cache.FindUnchanged( FilePath, Entry.Size, Entry.Timestamp );
+		TestNotNull( "Unchanged file", Found );
+		if ( Found )
+		{
+			TestEqual( "Hash", Found->Hash, Entry.Hash );
+			TestEqual( "Timestamp", Found->Timestamp, Entry.Timestamp );
+			for ( int32 i = 0; i < BYGLocStats::NumStatuses; ++i )
+			{
+				TestEqual( FString::Printf( TEXT( "Count %d" ), i ), Found->Stats.Counts[ i ], Entry.Stats.Counts[ i ] );
+			}
+		}
+		TestNull( "Resized file", Cache.FindUnchanged( FilePath, Entry.Size + 1, Entry.Timestamp ) );
+		TestNull( "Touched file", Cache.FindUnchanged( FilePath, Entry.Size, Entry.Timestamp + FTimespan::FromSeconds( 1 ) ) );
+		TestNotNull( "Touched file can still be matched by hash", Cache.Find( FilePath ) );
+	}
+
+	// Counts depend on the status settings, so changing them throws the cache away
+	Settings->NewStatus = TEXT( "Brand new" );
+	{
+		FBYGStatsCache Cache;
+		TestFalse( "Load cache with different settings", Cache.Load( CachePath, *Settings ) );
+		TestNull( "Entry after settings change", Cache.Find( FilePath ) );
+	}
+
+	IFileManager::Get().Delete( *CachePath );
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGTablePatchTest, FFunctionalTestBase, "BYG.Localization.TablePatch", TestFlags )
+bool FBYGTablePatchTest::RunTest( const FString& Parameters )
+{
+	FStringTableRef Table = FStringTable::NewStringTable();
+	Table->SetSourceString( TEXT( "Same" ), TEXT( "Unchanged" ) );
+	Table->SetSourceString( TEXT( "Typo" ), TEXT( "Helo" ) );
+	Table->SetSourceString( TEXT( "Case" ), TEXT( "lower" ) );
+	Table->SetSourceString( TEXT( "Gone" ), TEXT( "Removed" ) );
+
+	const TArray<TPair<FString, FString>> Pairs = {
+		{ TEXT( "Same" ), TEXT( "Unchanged" ) },
+		{ TEXT( "Typo" ), TEXT( "Hello" ) },
+		{ TEXT( "Case" ), TEXT( "LOWER" ) },
+		{ TEXT( "Added" ), TEXT( "First" ) },
+		// Later rows win, same as loading the whole file
+		{ TEXT( "Added" ), TEXT( "Second" ) },
+	};
+
+	FBYGStringTableLoader::FTablePatch Patch;
+	FBYGStringTableLoader::ComputePatch( *Table, Pairs, Patch );
+
+	// Display strings are compared case-sensitively, so "Case" counts as changed
+	TestEqual( "Changed rows", Patch.Changed.Num(), 3 );
+	TestEqual( "Removed rows", Patch.Removed.Num(), 1 );
+	if ( Patch.Removed.Num() == 1 )
+	{
+		TestEqual( "Removed key", Patch.Removed[ 0 ], FString( TEXT( "Gone" ) ) );
+	}
+	for ( const TPair<FString, FString>& Pair : Patch.Changed )
+	{
+		TestNotEqual( "Unchanged row is not patched", Pair.Key, FString( TEXT( "Same" ) ) );
+	}
+
+	const FStringTableEntryConstPtr SameEntryBefore = Table->FindEntry( TEXT( "Same" ) );
+	const uint32 GenerationBefore = FBYGStringTableLoader::GetTableGeneration();
+
+	FBYGStringTableLoader::ApplyPatch( Table, Patch );
+
+	FString SourceString;
+	TestTrue( "Typo fixed", Table->GetSourceString( TEXT( "Typo" ), SourceString ) && SourceString == TEXT( "Hello" ) );
+	TestTrue( "Case changed", Table->GetSourceString( TEXT( "Case" ), SourceString ) && SourceString.Equals( TEXT( "LOWER" ), ESearchCase::CaseSensitive ) );
+	TestTrue( "Last duplicate wins", Table->GetSourceString( TEXT( "Added" ), SourceString ) && SourceString == TEXT( "Second" ) );
+	TestFalse( "Removed row", Table->GetSourceString( TEXT( "Gone" ), SourceString ) );
+	TestTrue( "Unchanged entry is kept", Table->FindEntry( TEXT( "Same" ) ) == SameEntryBefore );
+	TestNotEqual( "Table generation bumped", FBYGStringTableLoader::GetTableGeneration(), GenerationBefore );
+
+	// Nothing left to do once the patch is applied
+	FBYGStringTableLoader::FTablePatch SecondPatch;
+	FBYGStringTableLoader::ComputePatch( *Table, Pairs, SecondPatch );
+	TestTrue( "Second patch is empty", SecondPatch.IsEmpty() );
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGCompiledLocalizationTest, FFunctionalTestBase, "BYG.Localization.CompiledLocalization", TestFlags )
+bool FBYGCompiledLocalizationTest::RunTest( const FString& Parameters )
+{
+	const FString CSV = FString( "Key,SourceString,Comment,Primary,Status\r\n" )
+		+ TEXT( "Greeting,\"Caf\u00E9, s'il vous pla\u00EEt\",,,\r\n" )
+		+ "Escaped,Line\\nbreak,,,\r\n"
+		+ "Empty,,,,\r\n"
+		// Later rows win, same as loading the CSV
+		+ "Twice,First,,,\r\n"
+		+ "Twice,Second,,,\r\n";
+	const TMap<FString, FString> Expected = {
+		{ TEXT( "Greeting" ), TEXT( "Caf\u00E9, s'il vous pla\u00EEt" ) },
+		{ TEXT( "Escaped" ), TEXT( "Line\nbreak" ) },
+		{ TEXT( "Empty" ), TEXT( "" ) },
+		{ TEXT( "Twice" ), TEXT( "Second" ) },
+	};
+
+	const FString Path = FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGLocalizationTest" ), TEXT( ".csv" ) );
+	const FString CompiledPath = FBYGStringTableLoader::GetCompiledPath( Path );
+	IFileManager& FileManager = IFileManager::Get();
+
+	auto TestTable = [this, &Expected]( const FString& What, const FStringTablePtr& Table )
+	{
+		if ( !TestTrue( What + " table", Table.IsValid() ) )
+			return;
+		int32 NumKeys = 0;
+		Table->EnumerateSourceStrings( [&NumKeys]( const FString& Key, const FString& SourceString ) { ++NumKeys; return true; } );
+		TestEqual( What + " keys", NumKeys, Expected.Num() );
+		for ( const auto& Pair : Expected )
+		{
+			FString SourceString;
+			TestTrue( What + " " + Pair.Key, Table->GetSourceString( Pair.Key, SourceString ) && SourceString.Equals( Pair.Value, ESearchCase::CaseSensitive ) );
+		}
+	};
+	auto LoadCompiled = [&Path]()
+	{
+		FStringTableRef Table = FStringTable::NewStringTable();
+		return FBYGStringTableLoader::LoadCompiled( Path, Table ) ? FStringTablePtr( Table ) : FStringTablePtr();
+	};
+
+	// Round trip
+	TestTrue( "Write", FFileHelper::SaveStringToFile( CSV, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM ) );
+	TestTrue( "Compile", FBYGStringTableLoader::Compile( Path ) );
+	TestTrue( "Compiled file exists", FileManager.FileExists( *CompiledPath ) );
+	TestTable( "Compiled", LoadCompiled() );
+	TestTable( "CSV", FBYGStringTableLoader::BuildStringTable( Path, TEXT( "BYGTest" ), false ) );
+	TestTable( "Build from compiled", FBYGStringTableLoader::BuildStringTable( Path, TEXT( "BYGTest" ), true ) );
+
+	// Staging doesn't keep modification times, the contents still match so the compiled file is used
+	const FDateTime Timestamp = FileManager.GetTimeStamp( *Path );
+	TestTrue( "Touch", FileManager.SetTimeStamp( *Path, Timestamp + FTimespan::FromMinutes( 1.0 ) ) );
+	TestTable( "Touched", LoadCompiled() );
+
+	// Same size but different contents is stale
+	const FString ChangedCSV = CSV.Replace( TEXT( "Second" ), TEXT( "Latest" ) );
+	TestTrue( "Write changed", FFileHelper::SaveStringToFile( ChangedCSV, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM ) );
+	TestTrue( "Change timestamp", FileManager.SetTimeStamp( *Path, Timestamp + FTimespan::FromMinutes( 2.0 ) ) );
+	TestFalse( "Stale file not loaded", LoadCompiled().IsValid() );
+	{
+		const FStringTablePtr Table = FBYGStringTableLoader::BuildStringTable( Path, TEXT( "BYGTest" ), true );
+		FString SourceString;
+		TestTrue( "Stale file falls back to CSV", Table.IsValid() && Table->GetSourceString( TEXT( "Twice" ), SourceString ) && SourceString == TEXT( "Latest" ) );
+	}
+	TestTrue( "Write original", FFileHelper::SaveStringToFile( CSV, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM ) );
+	TestTrue( "Recompile", FBYGStringTableLoader::Compile( Path ) );
+
+	// Corrupt files fall back to the CSV
+	TArray<uint8> CompiledData;
+	TestTrue( "Read compiled", FFileHelper::LoadFileToArray( CompiledData, *CompiledPath ) );
+	const TArray<uint8> Truncated( CompiledData.GetData(), CompiledData.Num() - 4 );
+	TestTrue( "Write truncated", FFileHelper::SaveArrayToFile( Truncated, *CompiledPath ) );
+	AddExpectedError( TEXT( "is corrupt, falling back to CSV" ), EAutomationExpectedErrorFlags::Contains, 0 );
+	TestFalse( "Truncated file not loaded", LoadCompiled().IsValid() );
+	TestTable( "Truncated falls back to CSV", FBYGStringTableLoader::BuildStringTable( Path, TEXT( "BYGTest" ), true ) );
+
+	const TArray<uint8> Garbage = { 'B', 'Y', 'G' };
+	TestTrue( "Write garbage", FFileHelper::SaveArrayToFile( Garbage, *CompiledPath ) );
+	TestFalse( "Garbage file not loaded", LoadCompiled().IsValid() );
+	TestTable( "Garbage falls back to CSV", FBYGStringTableLoader::BuildStringTable( Path, TEXT( "BYGTest" ), true ) );
+
+	FileManager.Delete( *Path );
+	FileManager.Delete( *CompiledPath );
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGStringTableAsyncTest, FFunctionalTestBase, "BYG.Localization.StringTableAsync", TestFlags )
+bool FBYGStringTableAsyncTest::RunTest( const FString& Parameters )
+{
+	FBYGTestLocalizationDirectory Dir;
+	const TArray<FString> Codes = { TEXT( "fr" ), TEXT( "de" ), TEXT( "es" ), TEXT( "it" ), TEXT( "ja" ) };
+	for ( const FString& Code : Codes )
+	{
+		TestTrue( "Write " + Code, Dir.Write( Code, FString( "Key,SourceString,Comment,Primary,Status\r\nGreeting," ) + Code + ",,,\r\n" ) );
+	}
+
+	const FName TableID( TEXT( "BYGTest_AsyncTable" ) );
+	const FString Namespace = TEXT( "BYGTest" );
+
+	auto GetGreeting = [TableID]()
+	{
+		FString SourceString;
+		const FStringTableConstPtr Table = FStringTableRegistry::Get().FindStringTable( TableID );
+		if ( Table.IsValid() )
+		{
+			Table->GetSourceString( TEXT( "Greeting" ), SourceString );
+		}
+		return SourceString;
+	};
+
+	// Shared so a late callback can't write to the stack if we give up waiting
+	TSharedRef<TMap<FString, bool>> Results = MakeShared<TMap<FString, bool>>();
+	auto RegisterAsync = [&Dir, TableID, Namespace, Results]( const FString& Code )
+	{
+		FBYGStringTableLoader::RegisterStringTableAsync( TableID, Dir.GetPath( Code ), Namespace, false, [Code, Results]( bool bSucceeded )
+		{
+			Results->Add( Code, bSucceeded );
+		} );
+	};
+
+	// Async loads finish in a game thread task, so pump the game thread until they are done
+	auto WaitUntil = [this]( const FString& What, TFunction<bool()> Done )
+	{
+		const double GiveUpTime = FPlatformTime::Seconds() + 10.0;
+		while ( !Done() && FPlatformTime::Seconds() < GiveUpTime )
+		{
+			FTaskGraphInterface::Get().ProcessThreadUntilIdle( ENamedThreads::GameThread );
+			FPlatformProcess::Sleep( 0.001f );
+		}
+		return TestTrue( What, Done() );
+	};
+
+	// Registering over a table we registered replaces it
+	TestTrue( "Register", FBYGStringTableLoader::RegisterStringTable( TableID, Dir.GetPath( "fr" ), Namespace, false ) );
+	TestEqual( "Registered", GetGreeting(), FString( "fr" ) );
+	TestTrue( "Register again", FBYGStringTableLoader::RegisterStringTable( TableID, Dir.GetPath( "de" ), Namespace, false ) );
+	TestEqual( "Replaced", GetGreeting(), FString( "de" ) );
+
+	// Only the latest of two async loads is registered, whichever finishes first
+	RegisterAsync( "es" );
+	RegisterAsync( "it" );
+	TestEqual( "Old table kept while loading", GetGreeting(), FString( "de" ) );
+	if ( WaitUntil( "Async loads finished", [Results]() { return Results->Num() == 2; } ) )
+	{
+		TestFalse( "Superseded load dropped", Results->FindRef( "es" ) );
+		TestTrue( "Latest load registered", Results->FindRef( "it" ) );
+		TestEqual( "Latest table", GetGreeting(), FString( "it" ) );
+	}
+	TestFalse( "No requests left", FBYGStringTableLoader::LatestAsyncRequests.Contains( TableID ) );
+
+	// Loading synchronously supersedes an async load that is still in flight
+	Results->Reset();
+	RegisterAsync( "fr" );
+	TestTrue( "Register while loading", FBYGStringTableLoader::RegisterStringTable( TableID, Dir.GetPath( "de" ), Namespace, false ) );
+	if ( WaitUntil( "Async load finished", [Results]() { return Results->Contains( "fr" ); } ) )
+	{
+		TestFalse( "Load superseded by register", Results->FindRef( "fr" ) );
+		TestEqual( "Registered table kept", GetGreeting(), FString( "de" ) );
+	}
+
+	// And so does unregistering
+	Results->Reset();
+	RegisterAsync( "es" );
+	FBYGStringTableLoader::UnregisterStringTable( TableID );
+	if ( WaitUntil( "Async load finished", [Results]() { return Results->Contains( "es" ); } ) )
+	{
+		TestFalse( "Load superseded by unregister", Results->FindRef( "es" ) );
+		TestFalse( "Table stays unregistered", FStringTableRegistry::Get().FindStringTable( TableID ).IsValid() );
+	}
+
+	// A finished preload is used as-is, the file is not read again
+	const FString PreloadPath = Dir.GetPath( "ja" );
+	FBYGStringTableLoader::PreloadStringTable( PreloadPath, Namespace, false );
+	WaitUntil( "Preload finished", [&PreloadPath]()
+	{
+		const FBYGStringTableLoader::FPreload* Preload = FBYGStringTableLoader::Preloads.Find( PreloadPath );
+		return Preload && Preload->Table.IsReady();
+	} );
+	TestTrue( "Change preloaded file", Dir.Write( "ja", "Key,SourceString,Comment,Primary,Status\r\nGreeting,Changed,,,\r\n" ) );
+	Results->Reset();
+	RegisterAsync( "ja" );
+	TestFalse( "Preload claimed", FBYGStringTableLoader::Preloads.Contains( PreloadPath ) );
+	if ( WaitUntil( "Preloaded load finished", [Results]() { return Results->Contains( "ja" ); } ) )
+	{
+		TestTrue( "Preloaded load registered", Results->FindRef( "ja" ) );
+		TestEqual( "Preloaded table used", GetGreeting(), FString( "ja" ) );
+	}
+
+	// Preloads nobody claims are dropped oldest first
+	for ( const FString& Code : Codes )
+	{
+		FBYGStringTableLoader::PreloadStringTable( Dir.GetPath( Code ), Namespace, false );
+	}
+	TestEqual( "Preloads capped", FBYGStringTableLoader::Preloads.Num(), FBYGStringTableLoader::MaxPreloads );
+	TestFalse( "Oldest preload dropped", FBYGStringTableLoader::Preloads.Contains( Dir.GetPath( Codes[ 0 ] ) ) );
+	TestTrue( "Latest preload kept", FBYGStringTableLoader::Preloads.Contains( Dir.GetPath( Codes.Last() ) ) );
+
+	// Let the preloads finish before their files are deleted
+	WaitUntil( "Preloads finished", []()
+	{
+		for ( const TPair<FString, FBYGStringTableLoader::FPreload>& Pair : FBYGStringTableLoader::Preloads )
+		{
+			if ( !Pair.Value.Table.IsReady() )
+				return false;
+		}
+		return true;
+	} );
+	FBYGStringTableLoader::Preloads.Empty();
+	FBYGStringTableLoader::UnregisterStringTable( TableID );
+
+	return true;
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGDiscoveryTest, FFunctionalTestBase, "BYG.Localization.Discovery", TestFlags )
+bool FBYGDiscoveryTest::RunTest( const FString& Parameters )
+{
+	const FString Root = FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGDiscoveryTest" ) );
+	const FString Header = TEXT( "Key,SourceString,Comment,Primary,Status\r\n" );
+	const TArray<FString> Files = {
+		TEXT( "loc_en.csv" ),
+		TEXT( "loc_fr.txt" ),
+		TEXT( "Sub/loc_es.csv" ),
+		TEXT( "Sub/Deeper/loc_it.csv" ),
+		// None of these match the prefix and extensions
+		TEXT( "notes.csv" ),
+		TEXT( "loc_de.csv.bak" ),
+		TEXT( "loc_de.csv.tmp" ),
+	};
+	for ( const FString& File : Files )
+	{
+		FFileHelper::SaveStringToFile( Header, *FPaths::Combine( Root, File ) );
+	}
+
+	UBYGLocalizationSettings* Settings = NewObject<UBYGLocalizationSettings>();
+	Settings->PrimaryLocalizationDirectory.Path = Root;
+	Settings->AdditionalLocalizationDirectories.Empty();
+	Settings->bIncludeSubdirectories = true;
+	Settings->MaxSubdirectoryDepth = 0;
+
+	UBYGLocalization* Loc = new UBYGLocalization();
+	Loc->Construct( MakeShared<UBYGLocalizationSettingsTestProvider>( Settings ) );
+
+	auto GetFilenames = [Loc]()
+	{
+		TArray<FString> Filenames;
+		for ( const FString& File : *Loc->GetLocalizationFilesSnapshot() )
+		{
+			Filenames.Add( FPaths::GetCleanFilename( File ) );
+		}
+		Filenames.Sort();
+		return FString::Join( Filenames, TEXT( "," ) );
+	};
+
+	TestEqual( "All subdirectories", GetFilenames(), FString( TEXT( "loc_en.csv,loc_es.csv,loc_fr.txt,loc_it.csv" ) ) );
+
+	// Discovery is cached until invalidated
+	const UBYGLocalization::FFileListRef FirstSnapshot = Loc->GetLocalizationFilesSnapshot();
+	FFileHelper::SaveStringToFile( Header, *FPaths::Combine( Root, TEXT( "loc_pt.csv" ) ) );
+	TestTrue( "Snapshot is reused", &Loc->GetLocalizationFilesSnapshot().Get() == &FirstSnapshot.Get() );
+	TestEqual( "New file is not found before invalidating", FirstSnapshot->Num(), 4 );
+	Loc->InvalidateLocalizationFiles();
+	TestEqual( "New file is found after invalidating", GetFilenames(), FString( TEXT( "loc_en.csv,loc_es.csv,loc_fr.txt,loc_it.csv,loc_pt.csv" ) ) );
+	TestEqual( "Old snapshot is unchanged", FirstSnapshot->Num(), 4 );
+
+	// Settings changes are picked up without invalidating
+	Settings->MaxSubdirectoryDepth = 1;
+	TestEqual( "One level of subdirectories", GetFilenames(), FString( TEXT( "loc_en.csv,loc_es.csv,loc_fr.txt,loc_pt.csv" ) ) );
+
+	Settings->bIncludeSubdirectories = false;
+	TestEqual( "No subdirectories", GetFilenames(), FString( TEXT( "loc_en.csv,loc_fr.txt,loc_pt.csv" ) ) );
+
+	delete Loc;
+	IFileManager::Get().DeleteDirectory( *Root, false, true );
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGCultureCacheTest, FFunctionalTestBase, "BYG.Localization.CultureCache", TestFlags )
+bool FBYGCultureCacheTest::RunTest( const FString& Parameters )
+{
+	FBYGCultureCache& Cache = FBYGCultureCache::Get();
+
+	const FBYGCultureCache::FEntry French = Cache.Find( TEXT( "fr" ) );
+	TestTrue( "French culture found", French.Culture.IsValid() );
+	TestFalse( "French has a native name", French.NativeName.IsEmpty() );
+
+	const FBYGCultureCache::FEntry Unknown = Cache.Find( TEXT( "not_a_culture" ) );
+	TestFalse( "Unknown culture", Unknown.Culture.IsValid() );
+	TestEqual( "Unknown culture falls back to its code", Unknown.NativeName.ToString(), FString( TEXT( "not_a_culture" ) ) );
+
+	// Once a code is cached, finding it again doesn't resolve anything. Find takes a view, so nothing in the
+	// loop makes a string
+	const int32 NumEntries = Cache.Num();
+	int32 NumAllocations = 0;
+	{
+		FBYGCountingMalloc CountingMalloc;
+		for ( int32 i = 0; i < 100; ++i )
+		{
+			Cache.Find( TEXT( "fr" ) );
+		}
+		NumAllocations = CountingMalloc.GetNumAllocations();
+	}
+	TestEqual( "Allocations for cached culture", NumAllocations, 0 );
+	TestEqual( "No new entries", Cache.Num(), NumEntries );
+	TestTrue( "Same culture", Cache.Find( TEXT( "fr" ) ).Culture == French.Culture );
+	TestTrue( "Codes ignore case", Cache.Find( TEXT( "FR" ) ).Culture == French.Culture );
+	TestEqual( "Still no new entries", Cache.Num(), NumEntries );
+
+	const FCulturePtr CanadianFrench = FInternationalization::Get().GetCulture( TEXT( "fr-CA" ) );
+	if ( CanadianFrench.IsValid() )
+	{
+		TestEqual( "Regional cultures use their language", Cache.GetLocaleCodeForCulture( CanadianFrench.ToSharedRef() ), FString( TEXT( "fr" ) ) );
+	}
+	for ( const TPair<FString, FString>& Override : FBYGCultureCache::GetLocaleCodeOverrides() )
+	{
+		const FCulturePtr Culture = FInternationalization::Get().GetCulture( Override.Key );
+		if ( Culture.IsValid() && Culture->GetName() == Override.Key )
+		{
+			TestEqual( Override.Key + " override", Cache.GetLocaleCodeForCulture( Culture.ToSharedRef() ), Override.Value );
+		}
+	}
+
+	return true;
+}
+
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST( FBYGMemoryTest, FFunctionalTestBase, "BYG.Localization.Memory", TestFlags )
+bool FBYGMemoryTest::RunTest( const FString& Parameters )
+{
+	const TArray<FBYGLocalizationEntry> Entries = {
+		FBYGLocalizationEntry( "Greeting", "Hello", "" ),
+		FBYGLocalizationEntry( "Farewell", "Goodbye", "Said when leaving" ),
+	};
+	const FBYGLocaleData Data( Entries );
+	TestTrue( "Locale data counts its text", Data.GetAllocatedSize() >= Data.GetNumChars() * sizeof( TCHAR ) );
+
+	FBYGMemoryHighWater HighWater;
+	HighWater.Add( 100 );
+	HighWater.Add( 50 );
+	HighWater.Remove( 100 );
+	HighWater.Add( 20 );
+	TestEqual( "Peak is the most held at once", HighWater.GetPeak(), (int64)150 );
+	HighWater.Reset();
+	TestEqual( "Reset peak", HighWater.GetPeak(), (int64)0 );
+
+	const FName TableID( "BYGLocalizationTest_Memory" );
+	FStringTableRef Table = FStringTable::NewStringTable();
+	Table->SetNamespace( "BYGLocalizationTest" );
+	Table->SetSourceString( "Greeting", "Hello" );
+	Table->SetSourceString( "Farewell", "Goodbye" );
+	FStringTableRegistry::Get().RegisterStringTable( TableID, Table );
+
+	FBYGStringTableLoader::FTableMemory Memory;
+	TestTrue( "Registered table has a report", FBYGStringTableLoader::GetTableMemory( TableID, Memory ) );
+	TestEqual( "Keys", Memory.NumKeys, 2 );
+	TestTrue( "Key bytes", Memory.KeyBytes >= ( FCString::Strlen( TEXT( "Greeting" ) ) + FCString::Strlen( TEXT( "Farewell" ) ) ) * sizeof( TCHAR ) );
+	TestTrue( "String bytes", Memory.StringBytes >= ( FCString::Strlen( TEXT( "Hello" ) ) + FCString::Strlen( TEXT( "Goodbye" ) ) ) * sizeof( TCHAR ) );
+	TestTrue( "Index bytes", Memory.IndexBytes > 0 );
+
+	FStringTableRegistry::Get().UnregisterStringTable( TableID );
+	TestFalse( "Unregistered table has no report", FBYGStringTableLoader::GetTableMemory( TableID, Memory ) );
+
+	return true;
+}
+
+
+#endif
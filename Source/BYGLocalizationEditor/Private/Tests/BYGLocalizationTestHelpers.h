@@ -0,0 +1,116 @@
+// Copyright 2017-2021 Brace Yourself Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BYGLocalization/Public/BYGLocalization.h"
+#include "BYGLocalizationSettings.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+class UBYGLocalizationSettingsTestProvider : public IBYGLocalizationSettingsProvider
+{
+public:
+	UBYGLocalizationSettingsTestProvider( UBYGLocalizationSettings* InSettings = nullptr )
+		: Blah( InSettings )
+	{
+	}
+
+	virtual const UBYGLocalizationSettings* GetSettings() const override
+	{
+		return Blah;
+	}
+protected:
+	UBYGLocalizationSettings* Blah;
+};
+
+// Swaps itself in as GMalloc while in scope and counts allocations made on the thread that created it.
+// Everything is forwarded to the real allocator so memory can be freed after it's swapped back out
+class FBYGCountingMalloc : public FMalloc
+{
+public:
+	FBYGCountingMalloc()
+		: Inner( GMalloc )
+		, ThreadId( FPlatformTLS::GetCurrentThreadId() )
+	{
+		GMalloc = this;
+	}
+	virtual ~FBYGCountingMalloc()
+	{
+		GMalloc = Inner;
+	}
+
+	int32 GetNumAllocations() const { return NumAllocations; }
+
+	virtual void* Malloc( SIZE_T Count, uint32 Alignment ) override
+	{
+		RecordAllocation();
+		return Inner->Malloc( Count, Alignment );
+	}
+	virtual void* Realloc( void* Original, SIZE_T Count, uint32 Alignment ) override
+	{
+		RecordAllocation();
+		return Inner->Realloc( Original, Count, Alignment );
+	}
+	virtual void Free( void* Original ) override { Inner->Free( Original ); }
+	virtual SIZE_T QuantizeSize( SIZE_T Count, uint32 Alignment ) override { return Inner->QuantizeSize( Count, Alignment ); }
+	virtual bool GetAllocationSize( void* Original, SIZE_T& SizeOut ) override { return Inner->GetAllocationSize( Original, SizeOut ); }
+	virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+	virtual const TCHAR* GetDescriptiveName() override { return TEXT( "BYGCountingMalloc" ); }
+
+protected:
+	void RecordAllocation()
+	{
+		if ( FPlatformTLS::GetCurrentThreadId() == ThreadId )
+		{
+			++NumAllocations;
+		}
+	}
+
+	FMalloc* Inner;
+	const uint32 ThreadId;
+	int32 NumAllocations = 0;
+};
+
+// A temp directory for loc_<code>.csv files, with settings that point at it. Deleted when it goes out of scope
+class FBYGTestLocalizationDirectory
+{
+public:
+	FBYGTestLocalizationDirectory()
+		: Directory( FPaths::CreateTempFilename( FPlatformProcess::UserTempDir(), TEXT( "BYGLocalizationTest" ) ) )
+		, Settings( NewObject<UBYGLocalizationSettings>() )
+	{
+		IFileManager::Get().MakeDirectory( *Directory, true );
+		Settings->PrimaryLocalizationDirectory.Path = Directory;
+		Settings->AdditionalLocalizationDirectories.Empty();
+		Settings->PrimaryLanguageCode = TEXT( "en" );
+		Settings->FilenamePrefix = TEXT( "loc_" );
+		Settings->FilenameSuffix = TEXT( "" );
+		Settings->PrimaryExtension = TEXT( "csv" );
+		Settings->bCreateBackup = false;
+		Settings->UpdateReportFormat = EBYGUpdateReportFormat::None;
+	}
+	~FBYGTestLocalizationDirectory()
+	{
+		IFileManager::Get().DeleteDirectory( *Directory, false, true );
+	}
+
+	FString GetPath( const FString& LanguageCode ) const
+	{
+		return FPaths::Combine( Directory, FString::Printf( TEXT( "loc_%s.csv" ), *LanguageCode ) );
+	}
+	bool Write( const FString& LanguageCode, const FString& Contents ) const
+	{
+		return FFileHelper::SaveStringToFile( Contents, *GetPath( LanguageCode ) );
+	}
+	FString Read( const FString& LanguageCode ) const
+	{
+		FString Contents;
+		FFileHelper::LoadFileToString( Contents, *GetPath( LanguageCode ) );
+		return Contents;
+	}
+
+	const FString Directory;
+	UBYGLocalizationSettings* const Settings;
+};
@@ -13,4 +13,6 @@ public:
 
 protected:
 	bool HandleSettingsSaved();
+	// Only does anything when running the cook commandlet
+	void CompileLocalizationsForCook();
 };